@@ -0,0 +1,505 @@
+#ifndef BVH_H_INCLUDED
+#define BVH_H_INCLUDED
+
+#include <vector>
+#include <memory>
+#include <numeric>
+#include <algorithm>
+#include <stdexcept>
+
+#include "ObjectHit.h"
+#include "ObjectList.h"
+#include "BoundingBox.h"
+#include "SoupeSpheres.h"
+#include "Statistiques.h"
+
+#include "../include/tinyxml2.h"
+
+// Les noeuds sont ranges a plat, en profondeur d'abord : l'enfant gauche suit
+// directement son parent, l'enfant droit est a l'indice `premier`.
+struct NoeudBVH {
+    BoundingBox boite;
+    int premier;  // feuille : premiere primitive ; noeud interne : enfant droit
+    int nombre;   // nombre de primitives de la feuille, 0 pour un noeud interne
+    int axe;      // axe de la coupe, pour visiter d'abord l'enfant le plus proche
+};
+
+// Hierarchie de volumes englobants construite selon l'heuristique de surface (SAH).
+// Si le monde ne contient que des spheres, les feuilles sont testees par paquets
+// dans une soupe de spheres rangee dans l'ordre des primitives.
+// Le parcours lit les noeuds a travers `arbre`, qui designe `noeuds` ou des noeuds
+// projetes en memoire depuis une scene binaire.
+// Si des primitives bougent, chaque noeud a aussi une boite a la fin de l'obturation
+// (`arbre_fin`) : la boite testee est interpolee a l'instant du rayon, ce qui la garde
+// serree autour des spheres rapides. `boite` est alors celle du debut de l'obturation.
+class BVH : public Object {
+public:
+    BVH() {}
+    BVH(const ObjectList& liste, double time0, double time1) : BVH(liste.objects, time0, time1) {}
+    BVH(const std::vector<shared_ptr<Object>>& objets, double time0, double time1);
+
+    // Construit sur les spheres d'une soupe ; la soupe du BVH est une copie reordonnee
+    BVH(const SoupeSpheres& spheres, double time0, double time1);
+
+    // Reprend tels quels des noeuds construits sur `soupe`, rangee dans l'ordre de leurs feuilles,
+    // pour l'intervalle [time0, time1] ; `boites_fin` est nul si rien ne bouge
+    BVH(const NoeudBVH* noeuds_existants, const BoundingBox* boites_fin, int nombre_noeuds, shared_ptr<SoupeSpheres> soupe,
+        double time0, double time1)
+        : soupe(std::move(soupe)), arbre(noeuds_existants), arbre_fin(boites_fin), taille_arbre(nombre_noeuds),
+          temps0(time0), temps1(time1) {}
+
+    BVH(const BVH&) = delete;
+    BVH& operator=(const BVH&) = delete;
+
+    virtual bool intersect(const rayon& r, double t_min, double t_max, EnregIntersect& record) const override;
+
+    virtual bool occluded(const rayon& r, double t_min, double t_max) const override;
+
+    virtual bool bounding_box(double time0, double time1, BoundingBox& ob) const override;
+
+    virtual tinyxml2::XMLElement* to_xml(tinyxml2::XMLDocument& xmlDoc) const override;
+
+    virtual void indexer(TableMateriaux& table, uint32_t& prochaine_primitive) override {
+        for (auto& obj : primitives)
+            obj->indexer(table, prochaine_primitive);
+    }
+
+    // Recalcule les boites aux deux bouts de [time0, time1] sans changer l'arbre, en O(n) :
+    // apres un changement d'intervalle d'obturation.
+    // Des noeuds projetes depuis une scene binaire sont d'abord recopies.
+    void ajuster(double time0, double time1);
+
+    double temps_debut() const { return temps0; }
+    double temps_fin() const { return temps1; }
+
+    // Profondeur maximale de l'arbre, qui borne la pile du parcours
+    static const int profondeur_max = 64;
+
+private:
+    static const int nombre_paniers = 16;
+    static const int taille_feuille_max = 8;
+
+    // Cout d'une traversee de noeud relativement a un test d'intersection
+    static constexpr double cout_traversee = 0.125;
+
+    // Construit tout l'arbre et renvoie l'ordre des primitives dans les feuilles
+    std::vector<int> construire(const std::vector<BoundingBox>& boites);
+
+    void construire(int indice_noeud, int profondeur, int debut, int fin, std::vector<int>& ordre,
+                    const std::vector<BoundingBox>& boites, const std::vector<point>& centres);
+
+    // Niveaux de coupes au milieu necessaires pour ramener n primitives a des feuilles
+    static int niveauxMedians(int n) {
+        int niveaux = 0;
+        for (long taille = taille_feuille_max; taille < n; taille *= 2)
+            niveaux++;
+        return niveaux;
+    }
+
+    // Cout d'intersection de n primitives : un test par paquet de la soupe
+    double coutPrimitives(int n) const { return (n + largeur_paquet - 1) / largeur_paquet; }
+
+    BoundingBox boitePrimitive(int i, double temps) const {
+        if (soupe) return soupe->boite(i, temps, temps);
+        BoundingBox b;
+        primitives[i]->bounding_box(temps, temps, b);
+        return b;
+    }
+
+    // Position d'un instant dans l'obturation, de 0 a 1 ; 0 si rien ne bouge
+    double fractionTemps(double temps) const {
+        if (arbre_fin == nullptr || temps1 <= temps0) return 0;
+        return std::clamp((temps - temps0) / (temps1 - temps0), 0.0, 1.0);
+    }
+
+    bool toucheNoeud(int n, double s, const point& origine, const vecteur3& inv_dir, double t_min, double t_max) const {
+        if (arbre_fin == nullptr)
+            return arbre[n].boite.intersect(origine, inv_dir, t_min, t_max);
+        // Test des dalles sur la boite interpolee, sans la construire
+        const BoundingBox& debut = arbre[n].boite;
+        const BoundingBox& fin = arbre_fin[n];
+        for (int a = 0; a < 3; a++) {
+            double bas = debut.minimum[a] + s * (fin.minimum[a] - debut.minimum[a]);
+            double haut = debut.maximum[a] + s * (fin.maximum[a] - debut.maximum[a]);
+            double t0 = (bas - origine[a]) * inv_dir[a];
+            double t1 = (haut - origine[a]) * inv_dir[a];
+            if (inv_dir[a] < 0.0)
+                std::swap(t0, t1);
+            t_min = t0 > t_min ? t0 : t_min;
+            t_max = t1 < t_max ? t1 : t_max;
+            if (t_max < t_min)
+                return false;
+        }
+        return true;
+    }
+
+public:
+    std::vector<shared_ptr<Object>> primitives;
+    std::vector<NoeudBVH> noeuds;
+    shared_ptr<SoupeSpheres> soupe;
+
+    std::vector<BoundingBox> boites_fin;
+
+    const NoeudBVH* arbre = nullptr;
+    const BoundingBox* arbre_fin = nullptr;  // nul si aucune primitive ne bouge
+    int taille_arbre = 0;
+
+private:
+    int largeur_paquet = 1;
+    double temps0 = 0, temps1 = 0;
+};
+
+BVH::BVH(const std::vector<shared_ptr<Object>>& objets, double time0, double time1) {
+    const int n = static_cast<int>(objets.size());
+    if (n == 0) return;
+
+    std::vector<BoundingBox> boites(n);
+    for (int i = 0; i < n; i++) {
+        if (!objets[i]->bounding_box(time0, time1, boites[i]))
+            throw std::invalid_argument("No bounding box in BVH constructor");
+    }
+
+    bool que_des_spheres = true;
+    for (const auto& obj : objets) {
+        if (!dynamic_cast<const SphereObject*>(obj.get()) && !dynamic_cast<const Mobile_Sphere*>(obj.get())) {
+            que_des_spheres = false;
+            break;
+        }
+    }
+    if (que_des_spheres)
+        largeur_paquet = SoupeSpheres::largeurPaquet();
+
+    std::vector<int> ordre = construire(boites);
+
+    primitives.reserve(n);
+    for (int i : ordre)
+        primitives.push_back(objets[i]);
+
+    if (que_des_spheres) {
+        soupe = make_shared<SoupeSpheres>();
+        for (const auto& obj : primitives)
+            soupe->ajouter(*obj);
+        soupe->finaliser();
+    }
+    ajuster(time0, time1);
+}
+
+BVH::BVH(const SoupeSpheres& spheres, double time0, double time1) {
+    const int n = spheres.nombre();
+    if (n == 0) return;
+
+    std::vector<BoundingBox> boites(n);
+    for (int i = 0; i < n; i++)
+        boites[i] = spheres.boite(i, time0, time1);
+
+    largeur_paquet = SoupeSpheres::largeurPaquet();
+    std::vector<int> ordre = construire(boites);
+
+    soupe = make_shared<SoupeSpheres>();
+    for (int i : ordre)
+        soupe->ajouter(point(spheres.cx[i], spheres.cy[i], spheres.cz[i]), vecteur3(spheres.vx[i], spheres.vy[i], spheres.vz[i]),
+                       spheres.rayons[i], spheres.materiaux_id[i], spheres.primitives_id[i]);
+    soupe->finaliser();
+    ajuster(time0, time1);
+}
+
+void BVH::ajuster(double time0, double time1) {
+    temps0 = time0;
+    temps1 = time1;
+    if (taille_arbre == 0) return;
+    if (arbre != noeuds.data()) {
+        noeuds.assign(arbre, arbre + taille_arbre);
+        arbre = noeuds.data();
+    }
+
+    auto meme_boite = [](const BoundingBox& a, const BoundingBox& b) {
+        for (int k = 0; k < 3; k++)
+            if (a.minimum[k] != b.minimum[k] || a.maximum[k] != b.maximum[k]) return false;
+        return true;
+    };
+
+    // Les enfants sont toujours ranges apres leur parent : un parcours a rebours les traite avant lui
+    boites_fin.resize(taille_arbre);
+    bool bouge = false;
+    for (int n = taille_arbre - 1; n >= 0; n--) {
+        NoeudBVH& noeud = noeuds[n];
+        if (noeud.nombre > 0) {
+            BoundingBox debut = boitePrimitive(noeud.premier, time0);
+            BoundingBox fin = boitePrimitive(noeud.premier, time1);
+            for (int i = noeud.premier + 1; i < noeud.premier + noeud.nombre; i++) {
+                debut = creer_surrounding_box(debut, boitePrimitive(i, time0));
+                fin = creer_surrounding_box(fin, boitePrimitive(i, time1));
+            }
+            noeud.boite = debut;
+            boites_fin[n] = fin;
+            bouge = bouge || !meme_boite(debut, fin);
+        }
+        else {
+            noeud.boite = creer_surrounding_box(noeuds[n + 1].boite, noeuds[noeud.premier].boite);
+            boites_fin[n] = creer_surrounding_box(boites_fin[n + 1], boites_fin[noeud.premier]);
+        }
+    }
+
+    if (!bouge) boites_fin.clear();
+    arbre_fin = bouge ? boites_fin.data() : nullptr;
+}
+
+std::vector<int> BVH::construire(const std::vector<BoundingBox>& boites) {
+    const int n = static_cast<int>(boites.size());
+    std::vector<point> centres(n);
+    for (int i = 0; i < n; i++)
+        centres[i] = boites[i].centre();
+
+    std::vector<int> ordre(n);
+    std::iota(ordre.begin(), ordre.end(), 0);
+
+    noeuds.reserve(2 * n);
+    noeuds.push_back(NoeudBVH());
+    construire(0, 0, 0, n, ordre, boites, centres);
+
+    arbre = noeuds.data();
+    taille_arbre = static_cast<int>(noeuds.size());
+    return ordre;
+}
+
+void BVH::construire(int indice_noeud, int profondeur, int debut, int fin, std::vector<int>& ordre,
+                     const std::vector<BoundingBox>& boites, const std::vector<point>& centres) {
+    BoundingBox boite = boites[ordre[debut]];
+    BoundingBox boite_centres(centres[ordre[debut]], centres[ordre[debut]]);
+    for (int i = debut + 1; i < fin; i++) {
+        boite = creer_surrounding_box(boite, boites[ordre[i]]);
+        boite_centres = creer_surrounding_box(boite_centres, centres[ordre[i]]);
+    }
+    noeuds[indice_noeud].boite = boite;
+
+    const int nombre = fin - debut;
+    int meilleur_axe = -1;
+    int meilleure_coupe = 0;
+    double meilleur_cout = infinity;
+
+    auto panier = [&](int i, int axe) {
+        double bas = boite_centres.minimum[axe];
+        double etendue = boite_centres.maximum[axe] - bas;
+        return std::min(nombre_paniers - 1, static_cast<int>(nombre_paniers * (centres[i][axe] - bas) / etendue));
+    };
+
+    for (int axe = 0; nombre > 1 && axe < 3; axe++) {
+        if (boite_centres.maximum[axe] - boite_centres.minimum[axe] <= 0) continue;
+
+        int compte[nombre_paniers] = {0};
+        BoundingBox boite_panier[nombre_paniers];
+        for (int i = debut; i < fin; i++) {
+            int p = panier(ordre[i], axe);
+            boite_panier[p] = compte[p] == 0 ? boites[ordre[i]] : creer_surrounding_box(boite_panier[p], boites[ordre[i]]);
+            compte[p]++;
+        }
+
+        // Balayage de droite a gauche pour les surfaces cumulees, puis de gauche a droite pour le cout
+        double surface_droite[nombre_paniers];
+        int compte_droite[nombre_paniers];
+        BoundingBox cumul;
+        int total = 0;
+        for (int p = nombre_paniers - 1; p > 0; p--) {
+            if (compte[p] > 0) {
+                cumul = total == 0 ? boite_panier[p] : creer_surrounding_box(cumul, boite_panier[p]);
+                total += compte[p];
+            }
+            surface_droite[p] = total > 0 ? cumul.surface() : 0;
+            compte_droite[p] = total;
+        }
+
+        total = 0;
+        for (int p = 0; p < nombre_paniers - 1; p++) {
+            if (compte[p] > 0) {
+                cumul = total == 0 ? boite_panier[p] : creer_surrounding_box(cumul, boite_panier[p]);
+                total += compte[p];
+            }
+            if (total == 0 || compte_droite[p + 1] == 0) continue;
+
+            double cout = coutPrimitives(total) * cumul.surface() + coutPrimitives(compte_droite[p + 1]) * surface_droite[p + 1];
+            if (cout < meilleur_cout) {
+                meilleur_cout = cout;
+                meilleur_axe = axe;
+                meilleure_coupe = p + 1;
+            }
+        }
+    }
+
+    double surface_parent = boite.surface();
+    if (meilleur_axe >= 0 && surface_parent > 0)
+        meilleur_cout = cout_traversee + meilleur_cout / surface_parent;
+
+    // Des coupes SAH tres desequilibrees (centroides presque confondus) allongent l'arbre : quand il ne
+    // reste que la profondeur necessaire pour finir par des coupes au milieu, on coupe au milieu
+    const bool profondeur_limite = profondeur + niveauxMedians(nombre) >= profondeur_max;
+
+    int milieu;
+    if (profondeur_limite && nombre > taille_feuille_max) {
+        meilleur_axe = boite_centres.axe_le_plus_long();
+        milieu = debut + nombre / 2;
+        std::nth_element(ordre.begin() + debut, ordre.begin() + milieu, ordre.begin() + fin,
+            [&](int a, int b) { return centres[a][meilleur_axe] < centres[b][meilleur_axe]; });
+    }
+    else if (profondeur_limite) {
+        noeuds[indice_noeud].premier = debut;
+        noeuds[indice_noeud].nombre = nombre;
+        noeuds[indice_noeud].axe = 0;
+        return;
+    }
+    else if (meilleur_axe >= 0 && (meilleur_cout < coutPrimitives(nombre) || nombre > taille_feuille_max)) {
+        milieu = static_cast<int>(std::partition(ordre.begin() + debut, ordre.begin() + fin,
+            [&](int i) { return panier(i, meilleur_axe) < meilleure_coupe; }) - ordre.begin());
+    }
+    else if (nombre > taille_feuille_max) {
+        // Centroides confondus : aucune coupe n'aide, on coupe au milieu pour borner la taille des feuilles
+        meilleur_axe = boite.axe_le_plus_long();
+        milieu = debut + nombre / 2;
+    }
+    else {
+        noeuds[indice_noeud].premier = debut;
+        noeuds[indice_noeud].nombre = nombre;
+        noeuds[indice_noeud].axe = 0;
+        return;
+    }
+
+    noeuds[indice_noeud].nombre = 0;
+    noeuds[indice_noeud].axe = meilleur_axe;
+
+    int gauche = static_cast<int>(noeuds.size());
+    noeuds.push_back(NoeudBVH());
+    construire(gauche, profondeur + 1, debut, milieu, ordre, boites, centres);
+
+    int droite = static_cast<int>(noeuds.size());
+    noeuds.push_back(NoeudBVH());
+    noeuds[indice_noeud].premier = droite;
+    construire(droite, profondeur + 1, milieu, fin, ordre, boites, centres);
+}
+
+bool BVH::intersect(const rayon& r, double t_min, double t_max, EnregIntersect& record) const {
+    if (taille_arbre == 0) return false;
+
+    vecteur3 d = r.direction();
+    vecteur3 inv_dir(1.0 / d.x(), 1.0 / d.y(), 1.0 / d.z());
+    point origine = r.origine();
+
+    bool object_was_hit = false;
+    auto closest_hit_distance = t_max;
+
+    // Avec la soupe, l'enregistrement n'est rempli qu'une fois, pour la sphere la plus proche
+    ParametresRayon parametres(r);
+    const double s = fractionTemps(r.temps());
+    int sphere_touchee = -1;
+
+    int pile[profondeur_max];
+    int taille_pile = 0;
+    int n = 0;
+    uint64_t tests = 0;  // primitives testees, comptees une fois a la fin du parcours
+
+    while (true) {
+        const NoeudBVH& noeud = arbre[n];
+        if (toucheNoeud(n, s, origine, inv_dir, t_min, closest_hit_distance)) {
+            tests += noeud.nombre;
+            if (noeud.nombre > 0 && soupe) {
+                int k = soupe->intersect_plage(parametres, noeud.premier, noeud.premier + noeud.nombre, t_min, closest_hit_distance);
+                if (k >= 0) sphere_touchee = k;
+            }
+            else if (noeud.nombre > 0) {
+                for (int i = noeud.premier; i < noeud.premier + noeud.nombre; i++) {
+                    if (primitives[i]->intersect(r, t_min, closest_hit_distance, record)) {
+                        object_was_hit = true;
+                        closest_hit_distance = record.t;
+                    }
+                }
+            }
+            else {
+                // On descend d'abord dans l'enfant situe du cote d'ou vient le rayon
+                if (inv_dir[noeud.axe] < 0) {
+                    pile[taille_pile++] = n + 1;
+                    n = noeud.premier;
+                }
+                else {
+                    pile[taille_pile++] = noeud.premier;
+                    n = n + 1;
+                }
+                continue;
+            }
+        }
+        if (taille_pile == 0) break;
+        n = pile[--taille_pile];
+    }
+
+    Statistiques::locaux().ajouter(TestsIntersection, tests);
+
+    if (sphere_touchee >= 0) {
+        soupe->remplir(r, sphere_touchee, closest_hit_distance, record);
+        object_was_hit = true;
+    }
+
+    return object_was_hit;
+}
+
+// Meme parcours que intersect, mais on s'arrete au premier obstacle
+bool BVH::occluded(const rayon& r, double t_min, double t_max) const {
+    if (taille_arbre == 0) return false;
+
+    vecteur3 d = r.direction();
+    vecteur3 inv_dir(1.0 / d.x(), 1.0 / d.y(), 1.0 / d.z());
+    point origine = r.origine();
+    ParametresRayon parametres(r);
+    const double s = fractionTemps(r.temps());
+
+    int pile[profondeur_max];
+    int taille_pile = 0;
+    int n = 0;
+    uint64_t tests = 0;  // primitives testees, comptees une fois a la fin du parcours
+
+    while (true) {
+        const NoeudBVH& noeud = arbre[n];
+        if (toucheNoeud(n, s, origine, inv_dir, t_min, t_max)) {
+            tests += noeud.nombre;
+            if (noeud.nombre > 0 && soupe) {
+                double t_limite = t_max;
+                if (soupe->intersect_plage(parametres, noeud.premier, noeud.premier + noeud.nombre, t_min, t_limite) >= 0) {
+                    Statistiques::locaux().ajouter(TestsIntersection, tests);
+                    return true;
+                }
+            }
+            else if (noeud.nombre > 0) {
+                for (int i = noeud.premier; i < noeud.premier + noeud.nombre; i++) {
+                    if (primitives[i]->occluded(r, t_min, t_max)) {
+                        Statistiques::locaux().ajouter(TestsIntersection, tests);
+                        return true;
+                    }
+                }
+            }
+            else {
+                pile[taille_pile++] = noeud.premier;
+                n = n + 1;
+                continue;
+            }
+        }
+        if (taille_pile == 0) break;
+        n = pile[--taille_pile];
+    }
+
+    Statistiques::locaux().ajouter(TestsIntersection, tests);
+    return false;
+}
+
+bool BVH::bounding_box(double time0, double time1, BoundingBox& ob) const {
+    if (taille_arbre == 0) return false;
+    ob = arbre_fin ? creer_surrounding_box(arbre[0].boite, arbre_fin[0]) : arbre[0].boite;
+    return true;
+}
+
+tinyxml2::XMLElement* BVH::to_xml(tinyxml2::XMLDocument& xmlDoc) const {
+    tinyxml2::XMLElement * element = xmlDoc.NewElement("ObjectList");
+
+    for (auto & item : primitives) {
+        element->InsertEndChild(item->to_xml(xmlDoc));
+    }
+
+    return element;
+}
+
+#endif // BVH_H_INCLUDED
@@ -0,0 +1,246 @@
+// Micro-bancs d'essai des noyaux du rendu (Google Benchmark), a graine fixe.
+// Se compile comme le moteur, sans main.cpp, en ajoutant -lbenchmark -lpthread :
+//   g++ -std=c++17 -O2 BancNoyaux.cpp <sources et bibliotheques du moteur> -lbenchmark -lpthread -o banc_noyaux
+// Chaque iteration traite une operation (un rayon, une interaction, un pixel) : le temps par
+// iteration donne directement le cout en ns/op.
+
+#include <benchmark/benchmark.h>
+
+#include <memory>
+#include <vector>
+
+#include "MoteurDeRendu.h"
+
+namespace {
+
+const uint64_t graine_banc = 0x5eed;
+
+// Rayons tires une fois pour toutes vers une boite de cote `etendue` centree a l'origine
+std::vector<rayon> rayons_vers_scene(int nombre, double etendue) {
+    Random::definir_graine(graine_banc);
+    Random::initialiser_flux(0, 0);
+    std::vector<rayon> rayons;
+    rayons.reserve(nombre);
+    for (int i = 0; i < nombre; i++) {
+        point origine(random_double(-etendue, etendue), random_double(-etendue, etendue), -4 * etendue);
+        point cible(random_double(-etendue, etendue), random_double(-etendue, etendue), random_double(-etendue, etendue));
+        rayons.push_back(rayon(origine, cible - origine, random_double()));
+    }
+    return rayons;
+}
+
+// Spheres de rayon 0.2 reparties dans un cube dont le volume croit avec leur nombre ;
+// une sur trois est mobile, comme dans generate_random_scene
+ObjectList scene_de_taille(int nombre, double& etendue) {
+    Random::definir_graine(graine_banc);
+    Random::initialiser_flux(1, 0);
+    etendue = std::cbrt(static_cast<double>(nombre));
+    auto m = make_shared<LambertianMateriau>(couleur(0.5, 0.5, 0.5));
+    ObjectList scene;
+    for (int i = 0; i < nombre; i++) {
+        point c(random_double(-etendue, etendue), random_double(-etendue, etendue), random_double(-etendue, etendue));
+        if (i % 3 == 0)
+            scene.add(make_shared<Mobile_Sphere>(c, c + vecteur3(0, random_double(0, .5), 0), 0.0, 1.0, 0.2, m));
+        else
+            scene.add(make_shared<SphereObject>(c, 0.2, m));
+    }
+    TableMateriaux table;
+    uint32_t prochaine_primitive = 0;
+    scene.indexer(table, prochaine_primitive);
+    return scene;
+}
+
+void BM_SphereObject_intersect(benchmark::State& state) {
+    SphereObject sphere(point(0, 0, 0), 1.0, make_shared<LambertianMateriau>(couleur(0.5, 0.5, 0.5)));
+    const std::vector<rayon> rayons = rayons_vers_scene(1024, 1.5);
+    EnregIntersect rec;
+    size_t i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(sphere.intersect(rayons[i++ & 1023], 0.001, infinity, rec));
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_SphereObject_intersect);
+
+void BM_Mobile_Sphere_intersect(benchmark::State& state) {
+    Mobile_Sphere sphere(point(0, 0, 0), point(0, 0.5, 0), 0.0, 1.0, 1.0, make_shared<LambertianMateriau>(couleur(0.5, 0.5, 0.5)));
+    const std::vector<rayon> rayons = rayons_vers_scene(1024, 1.5);
+    EnregIntersect rec;
+    size_t i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(sphere.intersect(rayons[i++ & 1023], 0.001, infinity, rec));
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_Mobile_Sphere_intersect);
+
+void BM_ObjectList_intersect(benchmark::State& state) {
+    double etendue;
+    const ObjectList scene = scene_de_taille(static_cast<int>(state.range(0)), etendue);
+    const std::vector<rayon> rayons = rayons_vers_scene(1024, etendue);
+    EnregIntersect rec;
+    size_t i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(scene.intersect(rayons[i++ & 1023], 0.001, infinity, rec));
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ObjectList_intersect)->RangeMultiplier(8)->Range(8, 4096);
+
+// Reference pour la liste : meme scene, meme rayons, a travers le BVH et sa soupe
+void BM_BVH_intersect(benchmark::State& state) {
+    double etendue;
+    const ObjectList scene = scene_de_taille(static_cast<int>(state.range(0)), etendue);
+    const BVH bvh(scene, 0.0, 1.0);
+    const std::vector<rayon> rayons = rayons_vers_scene(1024, etendue);
+    EnregIntersect rec;
+    size_t i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(bvh.intersect(rayons[i++ & 1023], 0.001, infinity, rec));
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_BVH_intersect)->RangeMultiplier(8)->Range(8, 32768);
+
+// Reajustement des boites a un nouvel intervalle d'obturation, compare a une construction
+void BM_BVH_ajuster(benchmark::State& state) {
+    double etendue;
+    const ObjectList scene = scene_de_taille(static_cast<int>(state.range(0)), etendue);
+    BVH bvh(scene, 0.0, 1.0);
+    int i = 0;
+    for (auto _ : state) {
+        bvh.ajuster(0.0, (i++ & 1) ? 1.0 : 0.5);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_BVH_ajuster)->RangeMultiplier(8)->Range(8, 32768);
+
+void BM_BVH_construire(benchmark::State& state) {
+    double etendue;
+    const ObjectList scene = scene_de_taille(static_cast<int>(state.range(0)), etendue);
+    for (auto _ : state)
+        benchmark::DoNotOptimize(BVH(scene, 0.0, 1.0).taille_arbre);
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_BVH_construire)->RangeMultiplier(8)->Range(8, 32768);
+
+// Interaction sur un impact fixe de la sphere unite ; commencer() est inclus, comme dans le moteur
+void BM_materiau_intercation(benchmark::State& state, std::shared_ptr<materiau> mat) {
+    Random::definir_graine(graine_banc);
+    Echantillonneur::configurer(TypeEchantillonneur::Sobol, 1024);
+    SphereObject sphere(point(0, 0, 0), 1.0, mat);
+    rayon incident(point(0.3, 0.2, -5), vecteur3(0, 0, 1));
+    EnregIntersect rec;
+    sphere.intersect(incident, 0.001, infinity, rec);
+
+    couleur attenuation;
+    rayon diffuse;
+    uint32_t i = 0;
+    for (auto _ : state) {
+        Echantillonneur::commencer(i & 63, (i >> 6) & 63, 64, i);
+        i++;
+        benchmark::DoNotOptimize(mat->intercation(incident, rec, attenuation, diffuse));
+        benchmark::DoNotOptimize(diffuse);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK_CAPTURE(BM_materiau_intercation, Lambertien, std::shared_ptr<materiau>(make_shared<LambertianMateriau>(couleur(0.5, 0.5, 0.5))));
+BENCHMARK_CAPTURE(BM_materiau_intercation, Metal, std::shared_ptr<materiau>(make_shared<MetalMateriau>(couleur(0.7, 0.6, 0.5), 0.3)));
+BENCHMARK_CAPTURE(BM_materiau_intercation, Dielectrique, std::shared_ptr<materiau>(make_shared<DielectricMateriau>(1.5)));
+BENCHMARK_CAPTURE(BM_materiau_intercation, Emissif, std::shared_ptr<materiau>(make_shared<EmissifMateriau>(couleur(4, 4, 4))));
+
+void BM_camera_getrayon(benchmark::State& state, double ouverture) {
+    Random::definir_graine(graine_banc);
+    Echantillonneur::configurer(TypeEchantillonneur::Sobol, 1024);
+    camera cam(point(13, 2, 3), point(0, 0, 0), vecteur3(0, 1, 0), 20.0, 1.5, ouverture, 10.0, 0.0, 1.0);
+    uint32_t i = 0;
+    for (auto _ : state) {
+        Echantillonneur::commencer(i & 63, (i >> 6) & 63, 64, i);
+        auto [u, v] = Echantillonneur::echantillon_2d();
+        i++;
+        benchmark::DoNotOptimize(cam.getrayon(u, v));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK_CAPTURE(BM_camera_getrayon, sans_ouverture, 0.0);
+BENCHMARK_CAPTURE(BM_camera_getrayon, ouverture, 0.1);
+
+// Chemin complet depuis la camera dans la scene de la vue par defaut ; `range(0)` : 1 pour le BVH, 0 pour la liste
+void BM_couleur_rayon(benchmark::State& state) {
+    Random::definir_graine(graine_banc);
+    Random::initialiser_flux(2, 0);
+    ObjectList scene = generate_random_scene();
+    TableMateriaux materiaux;
+    uint32_t prochaine_primitive = 0;
+    scene.indexer(materiaux, prochaine_primitive);
+    Lumieres lumieres;
+    lumieres.construire(scene.objects, materiaux);
+    shared_ptr<Object> monde = state.range(0) ? shared_ptr<Object>(make_shared<BVH>(scene, 0.0, 1.0))
+                                              : shared_ptr<Object>(make_shared<ObjectList>(scene));
+
+    Echantillonneur::configurer(TypeEchantillonneur::Sobol, 1024);
+    camera cam(point(13, 2, 3), point(0, 0, 0), vecteur3(0, 1, 0), 20.0, 1.5, 0.1, 10.0, 0.0, 1.0);
+    const RouletteRusse roulette;
+    const int largeur = 64, hauteur = 43;
+    uint32_t i = 0;
+    for (auto _ : state) {
+        const uint32_t pixel = i % (largeur * hauteur);
+        Echantillonneur::commencer(pixel % largeur, pixel / largeur, largeur, i / (largeur * hauteur));
+        i++;
+        auto [du, dv] = Echantillonneur::echantillon_2d();
+        rayon r = cam.getrayon((pixel % largeur + du) / (largeur - 1), (pixel / largeur + dv) / (hauteur - 1));
+        benchmark::DoNotOptimize(couleur_rayon(r, *monde, materiaux, lumieres, 50, roulette));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_couleur_rayon)->Arg(1)->Arg(0);
+
+// Ancienne resolution pixel par pixel
+void BM_entrer_couleur(benchmark::State& state) {
+    const int largeur = 256, hauteur = 256;
+    std::vector<sf::Uint8> pixels(4 * largeur * hauteur);
+    Random::definir_graine(graine_banc);
+    Random::initialiser_flux(3, 0);
+    std::vector<Couleur> sommes;
+    for (int k = 0; k < largeur * hauteur; k++)
+        sommes.emplace_back(100 * random_double(), 100 * random_double(), 100 * random_double());
+
+    int k = 0;
+    for (auto _ : state) {
+        entrer_couleur(pixels, sommes[k], 100, k / largeur, k % largeur, largeur);
+        k = (k + 1) % (largeur * hauteur);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_entrer_couleur);
+
+// Resolution par blocs utilisee par le moteur ; une iteration resout toute l'image, le debit est en pixels
+void BM_resoudre_pixels(benchmark::State& state) {
+    const int nombre_pixels = 256 * 256;
+    std::vector<float> rgb(3 * nombre_pixels);
+    std::vector<uint32_t> echantillons(nombre_pixels, 100);
+    std::vector<sf::Uint8> rgba(4 * nombre_pixels);
+    Random::definir_graine(graine_banc);
+    Random::initialiser_flux(4, 0);
+    for (float& v : rgb)
+        v = static_cast<float>(100 * random_double());
+
+    ParametresResolution parametres;
+    parametres.tonemap = static_cast<Tonemap>(state.range(0));
+    for (auto _ : state) {
+        resoudre_pixels(rgb.data(), echantillons.data(), nombre_pixels, parametres, rgba.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * nombre_pixels);
+}
+BENCHMARK(BM_resoudre_pixels)->DenseRange(0, 2);
+
+}
+
+BENCHMARK_MAIN();
@@ -0,0 +1,215 @@
+#ifndef BANCRENDU_H_INCLUDED
+#define BANCRENDU_H_INCLUDED
+
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/resource.h>
+
+#include "MoteurDeRendu.h"
+#include "ImageHDR.h"
+#include "SoupeSpheres.h"
+#include "Statistiques.h"
+
+// Banc d'essai de bout en bout : rend un corpus fixe de scenes XML (graines comprises dans
+// les fichiers) et mesure temps, debits, memoire et convergence vers une image de reference.
+// Les references sont <dossier>/references/<scene>.pfm, produites par le mode references.
+
+const char* const corpus_banc[] = {
+    "spheres_aleatoires", "verre", "flou_mouvement", "champ_spheres", "profondeur_champ"
+};
+
+struct OptionsBanc {
+    std::string dossier = "scenes";
+    std::string sortie;          // fichier JSON ; vide pour la sortie standard
+    int threads = 0;             // 0 : un thread par coeur
+    bool references = false;     // rend les references au lieu de mesurer
+    int facteur_reference = 16;  // echantillons des references, relativement a ceux de la scene
+};
+
+// Etat de l'image apres une passe ; rmse < 0 s'il n'y a pas de reference
+struct PointConvergence {
+    double temps;
+    double echantillons_par_pixel;
+    double rmse;
+};
+
+struct ResultatBanc {
+    std::string nom;
+    std::string erreur;  // vide si la scene a ete rendue
+    int largeur = 0, hauteur = 0;
+    int echantillons_par_pixel = 0;
+    double chargement = 0;   // lecture de la scene, en secondes
+    double temps_mur = 0;    // rendu (BVH compris), hors suivi de la convergence
+    TotauxStatistiques statistiques;
+    uint64_t echantillons = 0;
+    long rss_max_ko = 0;
+    std::vector<PointConvergence> courbe;
+};
+
+// Erreur quadratique moyenne sur toutes les composantes ; -1 si les tailles different
+double rmse(const std::vector<float>& image, const std::vector<float>& reference) {
+    if (image.size() != reference.size() || image.empty()) return -1;
+    double somme = 0;
+    for (size_t i = 0; i < image.size(); i++) {
+        double d = static_cast<double>(image[i]) - reference[i];
+        somme += d * d;
+    }
+    return std::sqrt(somme / image.size());
+}
+
+// Remet le pic de memoire residente du processus au niveau actuel (Linux 4.0 et plus) ;
+// sans effet ailleurs, le pic reste alors celui de tout le processus
+void remettre_pic_rss_a_zero() {
+    std::ofstream f("/proc/self/clear_refs");
+    if (f) f << "5";
+}
+
+long pic_rss_ko() {
+    std::ifstream f("/proc/self/status");
+    std::string ligne;
+    while (std::getline(f, ligne)) {
+        if (ligne.compare(0, 6, "VmHWM:") == 0)
+            return std::atol(ligne.c_str() + 6);
+    }
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+ResultatBanc executer_scene_banc(const std::string& nom, const OptionsBanc& options) {
+    using horloge = std::chrono::steady_clock;
+    auto secondes = [](horloge::duration d) { return std::chrono::duration<double>(d).count(); };
+
+    ResultatBanc resultat;
+    resultat.nom = nom;
+    const std::string chemin = options.dossier + "/" + nom + ".xml";
+    const std::string chemin_reference = options.dossier + "/references/" + nom + ".pfm";
+
+    remettre_pic_rss_a_zero();
+    auto debut_chargement = horloge::now();
+    MoteurRendu moteur(1, 1);
+    try {
+        moteur = MoteurRendu(chemin.c_str());
+    }
+    catch (std::exception& e) {
+        resultat.erreur = e.what();
+        return resultat;
+    }
+    resultat.chargement = secondes(horloge::now() - debut_chargement);
+
+    if (options.threads > 0) moteur.definirNombreThreads(options.threads);
+    resultat.largeur = moteur.obtenirLargeurImage();
+    resultat.hauteur = moteur.obtenirHauteurImage();
+
+    std::vector<float> reference;
+    if (!options.references) {
+        int largeur, hauteur;
+        if (!lire_pfm(chemin_reference, reference, largeur, hauteur) || largeur != resultat.largeur || hauteur != resultat.hauteur)
+            reference.clear();
+    }
+    else {
+        moteur.definirEchantillonsParPixel(moteur.obtenirEchantillonsParPixel() * options.facteur_reference);
+    }
+    resultat.echantillons_par_pixel = moteur.obtenirEchantillonsParPixel();
+
+    // Le calcul de l'erreur n'est pas compte dans le temps de rendu
+    const double pixels = static_cast<double>(resultat.largeur) * resultat.hauteur;
+    horloge::time_point debut;
+    double temps_suivi = 0;
+    moteur.definirRappelPasse([&](int) {
+        auto t = horloge::now();
+        PointConvergence point;
+        point.temps = secondes(t - debut) - temps_suivi;
+        point.echantillons_par_pixel = moteur.obtenirEchantillonsTotal() / pixels;
+        point.rmse = reference.empty() ? -1 : rmse(moteur.obtenirRadiance(), reference);
+        resultat.courbe.push_back(point);
+        temps_suivi += secondes(horloge::now() - t);
+    });
+
+    debut = horloge::now();
+    moteur.commencerTravail();
+    moteur.creerImage();
+    resultat.temps_mur = secondes(horloge::now() - debut) - temps_suivi;
+
+    resultat.statistiques = Statistiques::totaux();
+    resultat.echantillons = moteur.obtenirEchantillonsTotal();
+    resultat.rss_max_ko = pic_rss_ko();
+
+    if (options.references && !ecrire_pfm(chemin_reference, moteur.obtenirRadiance(), resultat.largeur, resultat.hauteur))
+        resultat.erreur = "Impossible d'enregistrer la reference " + chemin_reference;
+    return resultat;
+}
+
+void ecrire_json_banc(std::ostream& f, const std::vector<ResultatBanc>& resultats, int threads) {
+    f << "{\n";
+    f << "  \"version\": 1,\n";
+    f << "  \"machine\": {\"threads\": " << threads << ", \"simd\": " << json::chaine(SoupeSpheres::nomJeuInstructions())
+#ifdef __VERSION__
+      << ", \"compilateur\": " << json::chaine(__VERSION__)
+#endif
+      << "},\n";
+    f << "  \"scenes\": [";
+    for (size_t i = 0; i < resultats.size(); i++) {
+        const ResultatBanc& r = resultats[i];
+        f << (i ? ",\n" : "\n") << "    {\"nom\": " << json::chaine(r.nom);
+        if (!r.erreur.empty()) {
+            f << ", \"erreur\": " << json::chaine(r.erreur) << "}";
+            continue;
+        }
+        const double mrayons = r.temps_mur > 0 ? r.statistiques.rayons() / r.temps_mur / 1e6 : -1;
+        const double echantillons = r.temps_mur > 0 ? r.echantillons / r.temps_mur : -1;
+        f << ", \"largeur\": " << r.largeur << ", \"hauteur\": " << r.hauteur
+          << ", \"echantillons_par_pixel\": " << r.echantillons_par_pixel
+          << ",\n     \"chargement_s\": " << json::nombre(r.chargement) << ", \"temps_mur_s\": " << json::nombre(r.temps_mur)
+          << ", \"rayons\": " << r.statistiques.rayons() << ", \"mrayons_par_s\": " << json::nombre(mrayons)
+          << ", \"echantillons_par_s\": " << json::nombre(echantillons) << ", \"rss_max_ko\": " << r.rss_max_ko
+          << ",\n     \"statistiques\": ";
+        ecrire_json_statistiques(f, r.statistiques, r.temps_mur, threads);
+        f << ",\n     \"rmse_final\": " << json::nombre(r.courbe.empty() ? -1 : r.courbe.back().rmse)
+          << ",\n     \"courbe\": [";
+        for (size_t k = 0; k < r.courbe.size(); k++) {
+            const PointConvergence& p = r.courbe[k];
+            f << (k ? ", " : "") << "{\"temps_s\": " << json::nombre(p.temps)
+              << ", \"echantillons_par_pixel\": " << json::nombre(p.echantillons_par_pixel)
+              << ", \"rmse\": " << json::nombre(p.rmse) << "}";
+        }
+        f << "]}";
+    }
+    f << "\n  ]\n}\n";
+}
+
+// Codes de sortie : 0 succes, 1 scene illisible ou reference non enregistree, 2 JSON non enregistre
+int executer_bancs(const OptionsBanc& options) {
+    std::vector<ResultatBanc> resultats;
+    int code = 0;
+    if (options.references) {
+        std::error_code erreur;
+        std::filesystem::create_directories(options.dossier + "/references", erreur);
+    }
+    for (const char* nom : corpus_banc) {
+        std::cerr << (options.references ? "Reference " : "Banc ") << nom << "..." << std::endl;
+        resultats.push_back(executer_scene_banc(nom, options));
+        if (!resultats.back().erreur.empty()) {
+            std::cerr << "  " << resultats.back().erreur << std::endl;
+            code = 1;
+        }
+    }
+
+    const int threads = options.threads > 0 ? options.threads : static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    if (options.sortie.empty()) {
+        ecrire_json_banc(std::cout, resultats, threads);
+        return code;
+    }
+    std::ofstream f(options.sortie);
+    ecrire_json_banc(f, resultats, threads);
+    return f ? code : 2;
+}
+
+#endif // BANCRENDU_H_INCLUDED
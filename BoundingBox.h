@@ -1,2 +1,81 @@
-
-          
+#ifndef BOUNDINGBOX_H_INCLUDED
+#define BOUNDINGBOX_H_INCLUDED
+
+#include <algorithm>
+#include "rt.h"
+#include "vecteur3.h"
+#include "rayon.h"
+
+// Boite englobante alignee sur les axes (AABB)
+class BoundingBox {
+public:
+    BoundingBox() {}
+    BoundingBox(const point& a, const point& b) : minimum(a), maximum(b) {}
+
+    point min() const { return minimum; }
+    point max() const { return maximum; }
+
+    bool intersect(const rayon& r, double t_min, double t_max) const;
+
+    // Version utilisee pendant le parcours du BVH : l'inverse de la direction est calcule une seule fois par rayon
+    bool intersect(const point& origine, const vecteur3& inv_dir, double t_min, double t_max) const;
+
+    double surface() const;
+    int axe_le_plus_long() const;
+    point centre() const { return 0.5 * (minimum + maximum); }
+
+public:
+    point minimum;
+    point maximum;
+};
+
+using AABB = BoundingBox;
+
+bool BoundingBox::intersect(const rayon& r, double t_min, double t_max) const {
+    vecteur3 d = r.direction();
+    return intersect(r.origine(), vecteur3(1.0 / d.x(), 1.0 / d.y(), 1.0 / d.z()), t_min, t_max);
+}
+
+bool BoundingBox::intersect(const point& origine, const vecteur3& inv_dir, double t_min, double t_max) const {
+    for (int a = 0; a < 3; a++) {
+        auto t0 = (minimum[a] - origine[a]) * inv_dir[a];
+        auto t1 = (maximum[a] - origine[a]) * inv_dir[a];
+        if (inv_dir[a] < 0.0)
+            std::swap(t0, t1);
+        t_min = t0 > t_min ? t0 : t_min;
+        t_max = t1 < t_max ? t1 : t_max;
+        if (t_max < t_min)
+            return false;
+    }
+    return true;
+}
+
+double BoundingBox::surface() const {
+    vecteur3 d = maximum - minimum;
+    return 2.0 * (d.x() * d.y() + d.y() * d.z() + d.z() * d.x());
+}
+
+int BoundingBox::axe_le_plus_long() const {
+    vecteur3 d = maximum - minimum;
+    if (d.x() > d.y() && d.x() > d.z()) return 0;
+    return d.y() > d.z() ? 1 : 2;
+}
+
+BoundingBox creer_surrounding_box(const BoundingBox& b0, const BoundingBox& b1) {
+    point petit(fmin(b0.minimum.x(), b1.minimum.x()),
+                fmin(b0.minimum.y(), b1.minimum.y()),
+                fmin(b0.minimum.z(), b1.minimum.z()));
+
+    point grand(fmax(b0.maximum.x(), b1.maximum.x()),
+                fmax(b0.maximum.y(), b1.maximum.y()),
+                fmax(b0.maximum.z(), b1.maximum.z()));
+
+    return BoundingBox(petit, grand);
+}
+
+// Agrandit une boite pour contenir un point (utile pour les boites des centroides)
+BoundingBox creer_surrounding_box(const BoundingBox& b, const point& p) {
+    return creer_surrounding_box(b, BoundingBox(p, p));
+}
+
+#endif // BOUNDINGBOX_H_INCLUDED
@@ -0,0 +1,271 @@
+#ifndef DEBRUITEUR_H_INCLUDED
+#define DEBRUITEUR_H_INCLUDED
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define DEBRUITEUR_X86
+#endif
+
+#include "OrdonnanceurTuiles.h"
+
+#include "../include/tinyxml2.h"
+
+// Reglages du filtre a-trous guide (Dammertz et al. 2010)
+struct ParametresDebruitage {
+    bool actif = false;
+    int iterations = 5;
+    float sigma_couleur = 1.0f;     // relatif a la luminance du pixel
+    float sigma_normale = 0.2f;
+    float sigma_profondeur = 0.05f; // relatif a la profondeur du pixel
+    float sigma_albedo = 0.1f;
+
+    ParametresDebruitage() {}
+
+    static constexpr int iterations_max = 10;  // pas de 512 pixels a la derniere iteration
+    static constexpr float sigma_min = 1e-4f;  // les poids divisent par les sigmas
+
+    // Les valeurs hors bornes sont ramenees dans le domaine du filtre (un NaN donne le minimum)
+    ParametresDebruitage(tinyxml2::XMLElement* pElement) {
+        actif = pElement->BoolAttribute("Actif", actif);
+        iterations = std::clamp(pElement->IntAttribute("Iterations", iterations), 1, iterations_max);
+        sigma_couleur = std::max(sigma_min, pElement->FloatAttribute("SigmaCouleur", sigma_couleur));
+        sigma_normale = std::max(sigma_min, pElement->FloatAttribute("SigmaNormale", sigma_normale));
+        sigma_profondeur = std::max(sigma_min, pElement->FloatAttribute("SigmaProfondeur", sigma_profondeur));
+        sigma_albedo = std::max(sigma_min, pElement->FloatAttribute("SigmaAlbedo", sigma_albedo));
+    }
+
+    tinyxml2::XMLElement* to_xml(tinyxml2::XMLDocument& xmlDoc) const {
+        tinyxml2::XMLElement * pElement = xmlDoc.NewElement("Debruitage");
+        pElement->SetAttribute("Actif", actif);
+        pElement->SetAttribute("Iterations", iterations);
+        pElement->SetAttribute("SigmaCouleur", sigma_couleur);
+        pElement->SetAttribute("SigmaNormale", sigma_normale);
+        pElement->SetAttribute("SigmaProfondeur", sigma_profondeur);
+        pElement->SetAttribute("SigmaAlbedo", sigma_albedo);
+        return pElement;
+    }
+};
+
+// Signal et guides ranges en plans separes, pour les chargements vectoriels le long des lignes
+struct PlansDebruitage {
+    int largeur = 0, hauteur = 0;
+    std::vector<float> albedo[3];
+    std::vector<float> normale[3];
+    std::vector<float> profondeur;
+};
+
+// Constantes d'une iteration : l'ecart entre les prises double a chaque passage
+struct IterationAtrous {
+    int pas;
+    float inv_couleur, inv_normale, inv_profondeur, inv_albedo;
+};
+
+// Filtre les pixels [x0, x1) de la ligne y
+using NoyauAtrous = void (*)(const PlansDebruitage& guides, const std::vector<float>* entree, std::vector<float>* sortie,
+                             const IterationAtrous& it, int y, int x0, int x1);
+
+// Noyau B3-spline a 5 prises
+static const float poids_atrous[5] = {1.0f / 16, 1.0f / 4, 3.0f / 8, 1.0f / 4, 1.0f / 16};
+
+// Approximation rationnelle de exp(-d) pour d >= 0, identique en scalaire et en vectoriel
+inline float exp_negative_approchee(float d) {
+    return 1.0f / (1.0f + d * (1.0f + d * (0.5f + d * (1.0f / 6))));
+}
+
+inline void pixel_atrous(const PlansDebruitage& g, const std::vector<float>* entree, std::vector<float>* sortie,
+                         const IterationAtrous& it, int y, int x) {
+    const int l = g.largeur, h = g.hauteur;
+    const int p = y * l + x;
+
+    float c[3] = {entree[0][p], entree[1][p], entree[2][p]};
+    float lum = 0.2126f * c[0] + 0.7152f * c[1] + 0.0722f * c[2];
+    float inv_couleur = it.inv_couleur / (lum * lum + 1e-2f);
+    float inv_profondeur = it.inv_profondeur / (g.profondeur[p] + 1e-3f);
+
+    float somme_poids = 0, somme[3] = {0, 0, 0};
+    for (int dy = -2; dy <= 2; dy++) {
+        int yq = std::clamp(y + dy * it.pas, 0, h - 1);
+        for (int dx = -2; dx <= 2; dx++) {
+            int q = yq * l + std::clamp(x + dx * it.pas, 0, l - 1);
+
+            float dc = 0, dn = 0, da = 0;
+            for (int k = 0; k < 3; k++) {
+                float e = c[k] - entree[k][q];
+                float n = g.normale[k][p] - g.normale[k][q];
+                float a = g.albedo[k][p] - g.albedo[k][q];
+                dc += e * e;
+                dn += n * n;
+                da += a * a;
+            }
+            float d = dc * inv_couleur + dn * it.inv_normale + da * it.inv_albedo
+                    + std::fabs(g.profondeur[p] - g.profondeur[q]) * inv_profondeur;
+
+            float w = poids_atrous[dy + 2] * poids_atrous[dx + 2] * exp_negative_approchee(d);
+            somme_poids += w;
+            for (int k = 0; k < 3; k++)
+                somme[k] += w * entree[k][q];
+        }
+    }
+
+    for (int k = 0; k < 3; k++)
+        sortie[k][p] = somme[k] / somme_poids;
+}
+
+void ligne_atrous_scalaire(const PlansDebruitage& g, const std::vector<float>* entree, std::vector<float>* sortie,
+                           const IterationAtrous& it, int y, int x0, int x1) {
+    for (int x = x0; x < x1; x++)
+        pixel_atrous(g, entree, sortie, it, y, x);
+}
+
+#ifdef DEBRUITEUR_X86
+// 8 pixels consecutifs a la fois ; les bords, ou les prises sortent de l'image, restent scalaires
+__attribute__((target("avx2,fma")))
+void ligne_atrous_avx2(const PlansDebruitage& g, const std::vector<float>* entree, std::vector<float>* sortie,
+                       const IterationAtrous& it, int y, int x0, int x1) {
+    const int l = g.largeur, h = g.hauteur;
+    const int marge = 2 * it.pas;
+    const int debut = std::max(x0, marge);
+    const int fin = std::min(x1, l - marge);
+
+    const __m256 un = _mm256_set1_ps(1.0f), demi = _mm256_set1_ps(0.5f), sixieme = _mm256_set1_ps(1.0f / 6);
+    const __m256 masque_abs = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+    const __m256 inv_normale = _mm256_set1_ps(it.inv_normale), inv_albedo = _mm256_set1_ps(it.inv_albedo);
+
+    int x = x0;
+    for (; x < std::min(debut, x1); x++)
+        pixel_atrous(g, entree, sortie, it, y, x);
+
+    for (; x + 8 <= fin; x += 8) {
+        const int p = y * l + x;
+        __m256 c[3], n[3], a[3];
+        for (int k = 0; k < 3; k++) {
+            c[k] = _mm256_loadu_ps(&entree[k][p]);
+            n[k] = _mm256_loadu_ps(&g.normale[k][p]);
+            a[k] = _mm256_loadu_ps(&g.albedo[k][p]);
+        }
+        __m256 z = _mm256_loadu_ps(&g.profondeur[p]);
+
+        __m256 lum = _mm256_fmadd_ps(_mm256_set1_ps(0.2126f), c[0],
+                     _mm256_fmadd_ps(_mm256_set1_ps(0.7152f), c[1], _mm256_mul_ps(_mm256_set1_ps(0.0722f), c[2])));
+        __m256 inv_couleur = _mm256_div_ps(_mm256_set1_ps(it.inv_couleur), _mm256_fmadd_ps(lum, lum, _mm256_set1_ps(1e-2f)));
+        __m256 inv_profondeur = _mm256_div_ps(_mm256_set1_ps(it.inv_profondeur), _mm256_add_ps(z, _mm256_set1_ps(1e-3f)));
+
+        __m256 somme_poids = _mm256_setzero_ps();
+        __m256 somme[3] = {_mm256_setzero_ps(), _mm256_setzero_ps(), _mm256_setzero_ps()};
+
+        for (int dy = -2; dy <= 2; dy++) {
+            int yq = std::clamp(y + dy * it.pas, 0, h - 1);
+            for (int dx = -2; dx <= 2; dx++) {
+                const int q = yq * l + x + dx * it.pas;
+
+                __m256 dc = _mm256_setzero_ps(), dn = _mm256_setzero_ps(), da = _mm256_setzero_ps();
+                __m256 cq[3];
+                for (int k = 0; k < 3; k++) {
+                    cq[k] = _mm256_loadu_ps(&entree[k][q]);
+                    __m256 e = _mm256_sub_ps(c[k], cq[k]);
+                    __m256 nn = _mm256_sub_ps(n[k], _mm256_loadu_ps(&g.normale[k][q]));
+                    __m256 aa = _mm256_sub_ps(a[k], _mm256_loadu_ps(&g.albedo[k][q]));
+                    dc = _mm256_fmadd_ps(e, e, dc);
+                    dn = _mm256_fmadd_ps(nn, nn, dn);
+                    da = _mm256_fmadd_ps(aa, aa, da);
+                }
+                __m256 dz = _mm256_and_ps(masque_abs, _mm256_sub_ps(z, _mm256_loadu_ps(&g.profondeur[q])));
+
+                __m256 d = _mm256_mul_ps(dc, inv_couleur);
+                d = _mm256_fmadd_ps(dn, inv_normale, d);
+                d = _mm256_fmadd_ps(da, inv_albedo, d);
+                d = _mm256_fmadd_ps(dz, inv_profondeur, d);
+
+                __m256 polynome = _mm256_fmadd_ps(d, _mm256_fmadd_ps(d, _mm256_fmadd_ps(d, sixieme, demi), un), un);
+                __m256 w = _mm256_div_ps(_mm256_set1_ps(poids_atrous[dy + 2] * poids_atrous[dx + 2]), polynome);
+
+                somme_poids = _mm256_add_ps(somme_poids, w);
+                for (int k = 0; k < 3; k++)
+                    somme[k] = _mm256_fmadd_ps(w, cq[k], somme[k]);
+            }
+        }
+
+        for (int k = 0; k < 3; k++)
+            _mm256_storeu_ps(&sortie[k][p], _mm256_div_ps(somme[k], somme_poids));
+    }
+
+    for (; x < x1; x++)
+        pixel_atrous(g, entree, sortie, it, y, x);
+}
+#endif
+
+NoyauAtrous choisir_noyau_atrous() {
+#ifdef DEBRUITEUR_X86
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) return ligne_atrous_avx2;
+#endif
+    return ligne_atrous_scalaire;
+}
+
+// Debruite une image de radiance moyenne (RVB entrelace) guidee par l'albedo, la normale et
+// la profondeur du premier impact. L'eclairement est filtre apres division par l'albedo, puis
+// remultiplie : les details des materiaux ne sont pas flous. `pool` peut etre nul.
+std::vector<float> debruiter(const std::vector<float>& radiance, const std::vector<float>& albedo,
+                             const std::vector<float>& normale, const std::vector<float>& profondeur,
+                             int largeur, int hauteur, const ParametresDebruitage& parametres, PoolTuiles* pool) {
+    static const NoyauAtrous noyau = choisir_noyau_atrous();
+    const int n = largeur * hauteur;
+
+    PlansDebruitage guides;
+    guides.largeur = largeur;
+    guides.hauteur = hauteur;
+    guides.profondeur.assign(profondeur.begin(), profondeur.end());
+
+    std::vector<float> plans[2][3];
+    for (int k = 0; k < 3; k++) {
+        guides.albedo[k].resize(n);
+        guides.normale[k].resize(n);
+        plans[0][k].resize(n);
+        plans[1][k].resize(n);
+        for (int p = 0; p < n; p++) {
+            float a = albedo[3 * p + k];
+            guides.albedo[k][p] = a;
+            guides.normale[k][p] = normale[3 * p + k];
+            // Un albedo presque nul ne permet pas de retrouver l'eclairement : on filtre la radiance telle quelle
+            plans[0][k][p] = a > 1e-3f ? radiance[3 * p + k] / a : radiance[3 * p + k];
+        }
+    }
+
+    const std::vector<Tuile> tuiles = decouper_en_tuiles(largeur, hauteur, 64);
+    int courant = 0;
+    for (int i = 0; i < parametres.iterations; i++) {
+        // La tolerance sur la couleur se resserre a chaque iteration, comme l'ecart des prises s'elargit
+        IterationAtrous it;
+        it.pas = 1 << i;
+        it.inv_couleur = 1.0f / (parametres.sigma_couleur * parametres.sigma_couleur * std::ldexp(1.0f, -i));
+        it.inv_normale = 1.0f / (parametres.sigma_normale * parametres.sigma_normale);
+        it.inv_profondeur = 1.0f / parametres.sigma_profondeur;
+        it.inv_albedo = 1.0f / (parametres.sigma_albedo * parametres.sigma_albedo);
+
+        const std::vector<float>* entree = plans[courant];
+        std::vector<float>* sortie = plans[1 - courant];
+        auto travail = [&](const Tuile& t, int) {
+            for (int y = t.y0; y < t.y1; y++)
+                noyau(guides, entree, sortie, it, y, t.x0, t.x1);
+        };
+        if (pool != nullptr)
+            pool->executer(tuiles, travail);
+        else
+            for (const Tuile& t : tuiles) travail(t, 0);
+        courant = 1 - courant;
+    }
+
+    std::vector<float> resultat(3 * static_cast<size_t>(n));
+    for (int p = 0; p < n; p++) {
+        for (int k = 0; k < 3; k++) {
+            float a = albedo[3 * p + k];
+            resultat[3 * p + k] = a > 1e-3f ? plans[courant][k][p] * a : plans[courant][k][p];
+        }
+    }
+    return resultat;
+}
+
+#endif // DEBRUITEUR_H_INCLUDED
@@ -0,0 +1,233 @@
+#ifndef ECHANTILLONNEUR_H_INCLUDED
+#define ECHANTILLONNEUR_H_INCLUDED
+
+#include <cstdint>
+#include <cmath>
+#include <cstring>
+#include <utility>
+
+#include "rt.h"
+
+// Sequences utilisees pour les dimensions d'un echantillon (jitter du pixel, lentille, temps, rebonds)
+enum class TypeEchantillonneur { Independant, Stratifie, Halton, Sobol, BruitBleu };
+
+inline const char* nom_echantillonneur(TypeEchantillonneur type) {
+    switch (type) {
+        case TypeEchantillonneur::Independant: return "Independant";
+        case TypeEchantillonneur::Stratifie:   return "Stratifie";
+        case TypeEchantillonneur::Halton:      return "Halton";
+        case TypeEchantillonneur::BruitBleu:   return "BruitBleu";
+        default:                               return "Sobol";
+    }
+}
+
+// Sobol par defaut pour un nom inconnu ou absent
+inline TypeEchantillonneur echantillonneur_depuis_nom(const char* nom) {
+    if (nom == nullptr) return TypeEchantillonneur::Sobol;
+    for (auto type : {TypeEchantillonneur::Independant, TypeEchantillonneur::Stratifie, TypeEchantillonneur::Halton,
+                      TypeEchantillonneur::BruitBleu})
+        if (strcmp(nom, nom_echantillonneur(type)) == 0) return type;
+    return TypeEchantillonneur::Sobol;
+}
+
+// Position courante d'un chemin dans ses dimensions
+struct ContexteEchantillon {
+    uint32_t x = 0, y = 0;
+    uint32_t pixel = 0;
+    uint32_t indice = 0;     // numero de l'echantillon dans le pixel
+    uint32_t dimension = 0;  // prochaine dimension a consommer
+};
+
+inline uint32_t inverser_bits(uint32_t x) {
+    x = (x << 16) | (x >> 16);
+    x = ((x & 0x00ff00ffu) << 8) | ((x & 0xff00ff00u) >> 8);
+    x = ((x & 0x0f0f0f0fu) << 4) | ((x & 0xf0f0f0f0u) >> 4);
+    x = ((x & 0x33333333u) << 2) | ((x & 0xccccccccu) >> 2);
+    x = ((x & 0x55555555u) << 1) | ((x & 0xaaaaaaaau) >> 1);
+    return x;
+}
+
+// Brouillage d'Owen par hachage (Laine-Karras, constantes de Burley 2020)
+inline uint32_t brouillage_owen(uint32_t x, uint32_t graine) {
+    x = inverser_bits(x);
+    x ^= x * 0x3d20adeau;
+    x += graine;
+    x *= (graine >> 16) | 1;
+    x ^= x * 0x05526c56u;
+    x ^= x * 0x53a22864u;
+    return inverser_bits(x);
+}
+
+// Deuxieme dimension de Sobol ; la premiere est l'inverse des bits de l'indice
+inline uint32_t sobol_dimension1(uint32_t i) {
+    uint32_t resultat = 0;
+    for (uint32_t v = 1u << 31; i; i >>= 1, v ^= v >> 1)
+        if (i & 1) resultat ^= v;
+    return resultat;
+}
+
+// Permutation de [0, l) choisie par p, sans table (Kensler, "Correlated Multi-Jittered Sampling")
+inline uint32_t permuter(uint32_t i, uint32_t l, uint32_t p) {
+    uint32_t w = l - 1;
+    w |= w >> 1; w |= w >> 2; w |= w >> 4; w |= w >> 8; w |= w >> 16;
+    do {
+        i ^= p; i *= 0xe170893du; i ^= p >> 16; i ^= (i & w) >> 4;
+        i ^= p >> 8; i *= 0x0929eb3fu; i ^= p >> 23; i ^= (i & w) >> 1;
+        i *= 1 | p >> 27; i *= 0x6935fa69u; i ^= (i & w) >> 11; i *= 0x74dcb303u;
+        i ^= (i & w) >> 2; i *= 0x9e501cc3u; i ^= (i & w) >> 2; i *= 0xc860a3dfu;
+        i &= w; i ^= i >> 5;
+    } while (i >= l);
+    return (i + p) % l;
+}
+
+inline double inverse_radical(uint32_t i, uint32_t base) {
+    const double inv = 1.0 / base;
+    double f = inv, resultat = 0;
+    for (; i; i /= base, f *= inv)
+        resultat += (i % base) * f;
+    return resultat;
+}
+
+// Bruit de gradient entrelace (Jimenez) : un decalage par pixel dont l'erreur se repartit en bruit bleu
+inline double bruit_gradient_entrelace(double x, double y) {
+    double f = 0.06711056 * x + 0.00583715 * y;
+    f = 52.9829189 * (f - std::floor(f));
+    return f - std::floor(f);
+}
+
+// Echantillonneur partage par tous les threads ; seul le contexte est propre a chaque thread.
+// Le moteur appelle commencer() avant chaque echantillon et commencer_rebond() avant chaque
+// interaction : une dimension donnee sert donc toujours au meme usage, quel que soit le materiau.
+class Echantillonneur {
+public:
+    // Dimensions fixes de la camera ; chaque rebond en consomme ensuite dimensions_rebond :
+    // 3 pour la BSDF, puis 3 pour l'echantillonnage d'une lumiere
+    static const uint32_t dimensions_camera = 5;
+    static const uint32_t dimensions_rebond = 6;
+
+    static void configurer(TypeEchantillonneur valeur, int echantillons_par_pixel) {
+        type = valeur;
+        echantillons = echantillons_par_pixel > 0 ? static_cast<uint32_t>(echantillons_par_pixel) : 1;
+    }
+
+    static TypeEchantillonneur obtenir_type() { return type; }
+
+    // Positionne le thread sur l'echantillon `indice` du pixel (x, y), flux independant compris
+    static void commencer(uint32_t x, uint32_t y, uint32_t largeur, uint32_t indice) {
+        contexte_courant.x = x;
+        contexte_courant.y = y;
+        contexte_courant.pixel = y * largeur + x;
+        contexte_courant.indice = indice;
+        contexte_courant.dimension = 0;
+        Random::initialiser_flux(contexte_courant.pixel, indice);
+    }
+
+    static void commencer_rebond(int profondeur) {
+        contexte_courant.dimension = dimensions_camera + dimensions_rebond * static_cast<uint32_t>(profondeur);
+    }
+
+    static void commencer_lumiere(int profondeur) {
+        commencer_rebond(profondeur);
+        contexte_courant.dimension += 3;
+    }
+
+    static double echantillon_1d();
+    static std::pair<double, double> echantillon_2d();
+
+    // Acces au contexte du thread courant, pour suspendre et reprendre un chemin
+    static ContexteEchantillon& contexte() { return contexte_courant; }
+
+private:
+    static uint32_t graine_dimension(uint32_t dimension) {
+        return static_cast<uint32_t>(melanger_bits(Random::obtenir_graine() ^
+            melanger_bits((static_cast<uint64_t>(contexte_courant.pixel) << 32) | dimension)));
+    }
+
+    static double vers_unitaire(uint32_t x) { return x * (1.0 / 4294967296.0); }
+
+    static double fraction(double x) { return x - std::floor(x); }
+
+    static constexpr uint32_t premiers[32] = {
+        2, 3, 5, 7, 11, 13, 17, 19, 23, 29, 31, 37, 41, 43, 47, 53,
+        59, 61, 67, 71, 73, 79, 83, 89, 97, 101, 103, 107, 109, 113, 127, 131
+    };
+
+    static inline TypeEchantillonneur type = TypeEchantillonneur::Sobol;
+    static inline uint32_t echantillons = 1;
+    static inline thread_local ContexteEchantillon contexte_courant;
+};
+
+double Echantillonneur::echantillon_1d() {
+    const ContexteEchantillon& c = contexte_courant;
+    const uint32_t d = contexte_courant.dimension++;
+
+    switch (type) {
+        case TypeEchantillonneur::Stratifie: {
+            if (c.indice >= echantillons) break;
+            uint32_t strate = permuter(c.indice, echantillons, graine_dimension(d));
+            return (strate + random_double()) / echantillons;
+        }
+        case TypeEchantillonneur::Halton: {
+            // Au-dela de la table, les dimensions restantes sont independantes
+            if (d >= 32) break;
+            return fraction(inverse_radical(c.indice, premiers[d]) + vers_unitaire(graine_dimension(d)));
+        }
+        case TypeEchantillonneur::Sobol: {
+            // Sobol brouille d'Owen ; l'ordre des indices est melange par dimension (Burley 2020)
+            uint32_t graine = graine_dimension(d);
+            uint32_t i = brouillage_owen(c.indice, graine);
+            return vers_unitaire(brouillage_owen(inverser_bits(i), static_cast<uint32_t>(melanger_bits(graine))));
+        }
+        case TypeEchantillonneur::BruitBleu: {
+            double decalage = bruit_gradient_entrelace(c.x + 5.588238 * d, c.y + 5.588238 * d);
+            return fraction(decalage + c.indice * 0.6180339887498949);
+        }
+        default:
+            break;
+    }
+    return random_double();
+}
+
+std::pair<double, double> Echantillonneur::echantillon_2d() {
+    const ContexteEchantillon& c = contexte_courant;
+    const uint32_t d = contexte_courant.dimension;
+    contexte_courant.dimension += 2;
+
+    switch (type) {
+        case TypeEchantillonneur::Stratifie: {
+            // Grille m x m melangee ; les echantillons en surplus sont independants
+            uint32_t m = static_cast<uint32_t>(std::sqrt(static_cast<double>(echantillons)));
+            if (m == 0 || c.indice >= m * m) break;
+            uint32_t strate = permuter(c.indice, m * m, graine_dimension(d));
+            double u = (strate % m + random_double()) / m;
+            double v = (strate / m + random_double()) / m;
+            return {u, v};
+        }
+        case TypeEchantillonneur::Halton: {
+            if (d + 1 >= 32) break;
+            return {fraction(inverse_radical(c.indice, premiers[d]) + vers_unitaire(graine_dimension(d))),
+                    fraction(inverse_radical(c.indice, premiers[d + 1]) + vers_unitaire(graine_dimension(d + 1)))};
+        }
+        case TypeEchantillonneur::Sobol: {
+            // Les deux premieres dimensions de Sobol forment un (0,2)-reseau ; chaque paire a son brouillage
+            uint32_t graine = graine_dimension(d);
+            uint32_t i = brouillage_owen(c.indice, graine);
+            uint32_t graine_u = static_cast<uint32_t>(melanger_bits(graine));
+            uint32_t graine_v = static_cast<uint32_t>(melanger_bits(graine_u));
+            return {vers_unitaire(brouillage_owen(inverser_bits(i), graine_u)),
+                    vers_unitaire(brouillage_owen(sobol_dimension1(i), graine_v))};
+        }
+        case TypeEchantillonneur::BruitBleu: {
+            // Suite R2 (Roberts) decalee par pixel
+            double du = bruit_gradient_entrelace(c.x + 5.588238 * d, c.y + 5.588238 * d);
+            double dv = bruit_gradient_entrelace(c.x + 5.588238 * (d + 1), c.y + 5.588238 * (d + 1));
+            return {fraction(du + c.indice * 0.7548776662466927), fraction(dv + c.indice * 0.5698402909980532)};
+        }
+        default:
+            break;
+    }
+    double u = random_double();
+    return {u, random_double()};
+}
+
+#endif // ECHANTILLONNEUR_H_INCLUDED
@@ -0,0 +1,229 @@
+#ifndef IMAGEHDR_H_INCLUDED
+#define IMAGEHDR_H_INCLUDED
+
+#include <cctype>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// Lecture et ecriture d'images en radiance (RVB flottant, lignes de haut en bas)
+// au format PFM et OpenEXR (canaux FLOAT, sans compression). Fichiers petit-boutistes.
+
+inline bool finit_par(const std::string& nom, const char* extension) {
+    size_t n = strlen(extension);
+    if (nom.size() < n) return false;
+    for (size_t i = 0; i < n; i++)
+        if (tolower(nom[nom.size() - n + i]) != extension[i]) return false;
+    return true;
+}
+
+inline bool est_image_hdr(const std::string& nom) {
+    return finit_par(nom, ".pfm") || finit_par(nom, ".exr");
+}
+
+bool ecrire_pfm(const std::string& nom, const std::vector<float>& rgb, int largeur, int hauteur) {
+    std::ofstream f(nom, std::ios::binary);
+    if (!f) return false;
+
+    // Echelle negative : petit-boutiste ; les lignes sont rangees de bas en haut
+    f << "PF\n" << largeur << " " << hauteur << "\n-1.0\n";
+    for (int lig = hauteur - 1; lig >= 0; lig--)
+        f.write(reinterpret_cast<const char*>(&rgb[3 * static_cast<size_t>(lig) * largeur]), 3 * sizeof(float) * largeur);
+    return static_cast<bool>(f);
+}
+
+bool lire_pfm(const std::string& nom, std::vector<float>& rgb, int& largeur, int& hauteur) {
+    std::ifstream f(nom, std::ios::binary);
+    if (!f) return false;
+
+    std::string magique;
+    double echelle;
+    f >> magique >> largeur >> hauteur >> echelle;
+    f.get();
+    if (magique != "PF" || largeur <= 0 || hauteur <= 0) return false;
+
+    rgb.resize(3 * static_cast<size_t>(largeur) * hauteur);
+    for (int lig = hauteur - 1; lig >= 0; lig--)
+        f.read(reinterpret_cast<char*>(&rgb[3 * static_cast<size_t>(lig) * largeur]), 3 * sizeof(float) * largeur);
+    if (!f) return false;
+
+    // Echelle positive : gros-boutiste
+    if (echelle > 0) {
+        for (float& v : rgb) {
+            uint32_t bits;
+            memcpy(&bits, &v, 4);
+            bits = __builtin_bswap32(bits);
+            memcpy(&v, &bits, 4);
+        }
+    }
+    return true;
+}
+
+namespace exr {
+    template <class T> void ecrire(std::ostream& f, T valeur) {
+        f.write(reinterpret_cast<const char*>(&valeur), sizeof(T));
+    }
+
+    inline void attribut(std::ostream& f, const char* nom, const char* type, int32_t taille) {
+        f.write(nom, strlen(nom) + 1);
+        f.write(type, strlen(type) + 1);
+        ecrire(f, taille);
+    }
+
+    template <class T> bool lire(std::istream& f, T& valeur) {
+        return static_cast<bool>(f.read(reinterpret_cast<char*>(&valeur), sizeof(T)));
+    }
+
+    inline std::string lire_chaine(std::istream& f) {
+        std::string s;
+        std::getline(f, s, '\0');
+        return s;
+    }
+
+    const int32_t magique = 20000630;
+    const int32_t type_float = 2;
+}
+
+bool ecrire_exr(const std::string& nom, const std::vector<float>& rgb, int largeur, int hauteur) {
+    std::ofstream f(nom, std::ios::binary);
+    if (!f) return false;
+
+    exr::ecrire<int32_t>(f, exr::magique);
+    exr::ecrire<int32_t>(f, 2);  // version 2, lignes simples
+
+    // Les canaux sont ranges par ordre alphabetique
+    const char* canaux[3] = {"B", "G", "R"};
+    exr::attribut(f, "channels", "chlist", 3 * (2 + 16) + 1);
+    for (const char* c : canaux) {
+        f.write(c, 2);
+        exr::ecrire<int32_t>(f, exr::type_float);
+        exr::ecrire<int32_t>(f, 0);  // pLinear et octets reserves
+        exr::ecrire<int32_t>(f, 1);
+        exr::ecrire<int32_t>(f, 1);
+    }
+    f.put('\0');
+
+    exr::attribut(f, "compression", "compression", 1);
+    f.put('\0');
+    for (const char* fenetre : {"dataWindow", "displayWindow"}) {
+        exr::attribut(f, fenetre, "box2i", 16);
+        for (int32_t v : {0, 0, largeur - 1, hauteur - 1})
+            exr::ecrire(f, v);
+    }
+    exr::attribut(f, "lineOrder", "lineOrder", 1);
+    f.put('\0');
+    exr::attribut(f, "pixelAspectRatio", "float", 4);
+    exr::ecrire(f, 1.0f);
+    exr::attribut(f, "screenWindowCenter", "v2f", 8);
+    exr::ecrire(f, 0.0f);
+    exr::ecrire(f, 0.0f);
+    exr::attribut(f, "screenWindowWidth", "float", 4);
+    exr::ecrire(f, 1.0f);
+    f.put('\0');
+
+    // Table des positions des lignes, puis les lignes : y, taille, et un canal apres l'autre
+    const int32_t taille_ligne = 3 * 4 * largeur;
+    const uint64_t debut = static_cast<uint64_t>(f.tellp()) + 8 * static_cast<uint64_t>(hauteur);
+    for (int lig = 0; lig < hauteur; lig++)
+        exr::ecrire<uint64_t>(f, debut + static_cast<uint64_t>(lig) * (8 + taille_ligne));
+
+    std::vector<float> canal(largeur);
+    for (int lig = 0; lig < hauteur; lig++) {
+        exr::ecrire<int32_t>(f, lig);
+        exr::ecrire<int32_t>(f, taille_ligne);
+        for (int c = 2; c >= 0; c--) {
+            for (int i = 0; i < largeur; i++)
+                canal[i] = rgb[3 * (static_cast<size_t>(lig) * largeur + i) + c];
+            f.write(reinterpret_cast<const char*>(canal.data()), 4 * largeur);
+        }
+    }
+    return static_cast<bool>(f);
+}
+
+// Ne relit que les fichiers sans compression dont tous les canaux sont FLOAT, comme ceux d'ecrire_exr
+bool lire_exr(const std::string& nom, std::vector<float>& rgb, int& largeur, int& hauteur) {
+    std::ifstream f(nom, std::ios::binary);
+    if (!f) return false;
+
+    int32_t magique, version;
+    if (!exr::lire(f, magique) || !exr::lire(f, version) || magique != exr::magique || (version & 0xff) != 2 || (version & 0x200))
+        return false;
+
+    std::vector<std::string> canaux;
+    int32_t fenetre[4] = {0, 0, -1, -1};
+    while (true) {
+        std::string nom_attribut = exr::lire_chaine(f);
+        if (nom_attribut.empty()) break;
+        std::string type = exr::lire_chaine(f);
+        int32_t taille;
+        if (!exr::lire(f, taille)) return false;
+
+        if (nom_attribut == "channels") {
+            while (true) {
+                std::string canal = exr::lire_chaine(f);
+                if (canal.empty()) break;
+                int32_t type_pixel, reserve, ex, ey;
+                exr::lire(f, type_pixel); exr::lire(f, reserve); exr::lire(f, ex); exr::lire(f, ey);
+                if (type_pixel != exr::type_float || ex != 1 || ey != 1) return false;
+                canaux.push_back(canal);
+            }
+        }
+        else if (nom_attribut == "compression") {
+            if (f.get() != 0) return false;
+        }
+        else if (nom_attribut == "dataWindow") {
+            for (int32_t& v : fenetre) exr::lire(f, v);
+        }
+        else {
+            f.ignore(taille);
+        }
+        if (!f) return false;
+    }
+
+    largeur = fenetre[2] - fenetre[0] + 1;
+    hauteur = fenetre[3] - fenetre[1] + 1;
+    if (largeur <= 0 || hauteur <= 0 || canaux.empty()) return false;
+
+    // Position de chaque canal dans le pixel RVB, -1 pour ceux qu'on ignore (alpha...)
+    std::vector<int> destination;
+    for (const std::string& c : canaux)
+        destination.push_back(c == "R" ? 0 : c == "G" ? 1 : c == "B" ? 2 : -1);
+
+    std::vector<uint64_t> positions(hauteur);
+    for (uint64_t& p : positions) exr::lire(f, p);
+
+    rgb.assign(3 * static_cast<size_t>(largeur) * hauteur, 0.0f);
+    std::vector<float> canal(largeur);
+    for (uint64_t p : positions) {
+        f.seekg(static_cast<std::streamoff>(p));
+        int32_t y, taille;
+        if (!exr::lire(f, y) || !exr::lire(f, taille)) return false;
+        int lig = y - fenetre[1];
+        if (lig < 0 || lig >= hauteur) return false;
+        for (int d : destination) {
+            f.read(reinterpret_cast<char*>(canal.data()), 4 * largeur);
+            if (d < 0) continue;
+            for (int i = 0; i < largeur; i++)
+                rgb[3 * (static_cast<size_t>(lig) * largeur + i) + d] = canal[i];
+        }
+        if (!f) return false;
+    }
+    return true;
+}
+
+// Choisit le format d'apres l'extension (.pfm ou .exr)
+bool ecrire_image_hdr(const std::string& nom, const std::vector<float>& rgb, int largeur, int hauteur) {
+    if (finit_par(nom, ".exr")) return ecrire_exr(nom, rgb, largeur, hauteur);
+    if (finit_par(nom, ".pfm")) return ecrire_pfm(nom, rgb, largeur, hauteur);
+    return false;
+}
+
+bool lire_image_hdr(const std::string& nom, std::vector<float>& rgb, int& largeur, int& hauteur) {
+    if (finit_par(nom, ".exr")) return lire_exr(nom, rgb, largeur, hauteur);
+    if (finit_par(nom, ".pfm")) return lire_pfm(nom, rgb, largeur, hauteur);
+    return false;
+}
+
+#endif // IMAGEHDR_H_INCLUDED
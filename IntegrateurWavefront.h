@@ -0,0 +1,327 @@
+#ifndef INTEGRATEURWAVEFRONT_H_INCLUDED
+#define INTEGRATEURWAVEFRONT_H_INCLUDED
+
+#include <vector>
+#include <algorithm>
+
+#include "rt.h"
+#include "Echantillonneur.h"
+#include "vecteur3.h"
+#include "rayon.h"
+#include "camera.h"
+#include "ObjectHit.h"
+#include "materiau.h"
+#include "OrdonnanceurTuiles.h"
+#include "Lumieres.h"
+#include "Statistiques.h"
+
+enum class TypeIntegrateur { Recursif, Wavefront };
+
+// Degrade du ciel, seule source de lumiere de la scene
+couleur couleur_ciel(const rayon& r) {
+    vecteur3 direction_unite = vecteur_unitaire(r.direction());
+    auto t = 0.5*(direction_unite.y() + 1.0);
+    return (1.0-t)*couleur(1.0, 1.0, 1.0) + t*couleur(0.5, 0.7, 1.0);
+}
+
+// Donnees du premier impact d'un echantillon, qui guident le debruiteur.
+// Un rayon qui s'echappe prend la couleur du ciel comme albedo, une normale nulle et une profondeur nulle.
+struct EchantillonAOV {
+    couleur albedo;
+    vecteur3 normale;
+    double profondeur = 0;
+
+    void ajouter(const EchantillonAOV& e) {
+        albedo += e.albedo;
+        normale += e.normale;
+        profondeur += e.profondeur;
+    }
+};
+
+EchantillonAOV aov_premier_impact(const rayon& r, bool touche, const EnregIntersect& rec, const TableMateriaux& materiaux) {
+    EchantillonAOV aov;
+    if (touche) {
+        aov.albedo = materiaux[rec.materiau_id].albedo();
+        aov.normale = rec.surface_normal;
+        aov.profondeur = rec.t * r.direction().norme();
+    }
+    else {
+        aov.albedo = couleur_ciel(r);
+    }
+    return aov;
+}
+
+// Roulette russe : a partir de profondeur_min rebonds, un chemin survit avec une probabilite
+// egale a la plus grande composante de son debit (bornee par survie_max), et son debit est
+// divise par cette probabilite pour que l'estimateur reste sans biais.
+struct RouletteRusse {
+    int profondeur_min = 3;
+    double survie_max = 0.95;
+
+    // Renvoie false si le chemin est termine, sinon compense son debit
+    bool survit(int profondeur, couleur& debit) const {
+        if (profondeur < profondeur_min) return true;
+        double q = std::min(survie_max, std::max({debit.x(), debit.y(), debit.z()}));
+        if (q <= 0 || random_double() >= q) return false;
+        debit /= q;
+        return true;
+    }
+};
+
+// Etats des chemins en vol, ranges en structure de tableaux (SoA)
+struct EtatsChemins {
+    std::vector<double> ox, oy, oz;
+    std::vector<double> dx, dy, dz;
+    std::vector<double> temps;
+    std::vector<double> debit_r, debit_g, debit_b;
+    std::vector<double> px_prec, py_prec, pz_prec, pdf_prec;  // sommet precedent, pour le MIS
+    std::vector<int> echantillon;   // indice de l'echantillon dans le lot
+    std::vector<PCG32> flux;        // etat du generateur propre au chemin
+    std::vector<ContexteEchantillon> contextes;
+    int nombre = 0;
+
+    void redimensionner(int n) {
+        for (auto* v : {&ox, &oy, &oz, &dx, &dy, &dz, &temps, &debit_r, &debit_g, &debit_b,
+                        &px_prec, &py_prec, &pz_prec, &pdf_prec})
+            v->resize(n);
+        echantillon.resize(n);
+        flux.resize(n);
+        contextes.resize(n);
+    }
+
+    rayon obtenir_rayon(int i) const {
+        return rayon(point(ox[i], oy[i], oz[i]), vecteur3(dx[i], dy[i], dz[i]), temps[i]);
+    }
+
+    void definir_rayon(int i, const rayon& r) {
+        point o = r.origine();
+        vecteur3 d = r.direction();
+        ox[i] = o.x(); oy[i] = o.y(); oz[i] = o.z();
+        dx[i] = d.x(); dy[i] = d.y(); dz[i] = d.z();
+        temps[i] = r.temps();
+    }
+
+    void copier(int dest, int src) {
+        for (auto* v : {&ox, &oy, &oz, &dx, &dy, &dz, &temps, &debit_r, &debit_g, &debit_b,
+                        &px_prec, &py_prec, &pz_prec, &pdf_prec})
+            (*v)[dest] = (*v)[src];
+        echantillon[dest] = echantillon[src];
+        flux[dest] = flux[src];
+        contextes[dest] = contextes[src];
+    }
+};
+
+// Integrateur iteratif : les chemins d'un lot avancent ensemble, rebond par rebond,
+// a travers des etapes separees (extension, ombrage par type de materiau, compaction).
+class IntegrateurWavefront {
+public:
+    static const int taille_lot = 8192;
+
+    // Rend, pour chaque pixel p de la tuile, les echantillons [premier[p], premier[p] + nombre[p]) ;
+    // `accumulation` recoit leur somme par pixel et `carres` la somme des carres de leur luminance
+    void rendreTuile(const Tuile& tuile, int largeur_img, int hauteur_img,
+                     const std::vector<int>& premier, const std::vector<int>& nombre,
+                     int profondeur_max, const RouletteRusse& roulette, const camera& cam, const Object& monde,
+                     const TableMateriaux& materiaux, const Lumieres& lumieres,
+                     std::vector<couleur>& accumulation, std::vector<double>& carres,
+                     std::vector<EchantillonAOV>* aov = nullptr);
+
+private:
+    void etendre(const Object& monde, const TableMateriaux& materiaux, const Lumieres& lumieres);
+    void trier(const TableMateriaux& materiaux);
+    template <class M> void ombrer(const std::vector<int>& file, const Object& monde, const TableMateriaux& materiaux,
+                                   const Lumieres& lumieres, int profondeur, const RouletteRusse& roulette);
+    void compacter();
+
+    EtatsChemins chemins;
+    std::vector<EnregIntersect> impacts;
+    std::vector<char> vivant;
+    std::vector<couleur> radiance;
+    std::vector<int> pixel_tache, echantillon_tache;
+    std::vector<int> file_lambertien, file_metal, file_dielectrique;
+};
+
+void IntegrateurWavefront::rendreTuile(const Tuile& tuile, int largeur_img, int hauteur_img,
+                                       const std::vector<int>& premier, const std::vector<int>& nombre,
+                                       int profondeur_max, const RouletteRusse& roulette, const camera& cam, const Object& monde,
+                                       const TableMateriaux& materiaux, const Lumieres& lumieres,
+                                       std::vector<couleur>& accumulation, std::vector<double>& carres,
+                                       std::vector<EchantillonAOV>* aov) {
+    const int largeur_tuile = tuile.x1 - tuile.x0;
+    const int nombre_pixels = largeur_tuile * (tuile.y1 - tuile.y0);
+    accumulation.assign(nombre_pixels, couleur(0, 0, 0));
+    carres.assign(nombre_pixels, 0.0);
+    if (aov != nullptr) aov->assign(nombre_pixels, EchantillonAOV());
+
+    // Les echantillons sont parcourus pixel par pixel, comme dans l'integrateur recursif
+    pixel_tache.clear();
+    echantillon_tache.clear();
+    for (int p = 0; p < nombre_pixels; p++) {
+        for (int s = premier[p]; s < premier[p] + nombre[p]; s++) {
+            pixel_tache.push_back(p);
+            echantillon_tache.push_back(s);
+        }
+    }
+    const long total = static_cast<long>(pixel_tache.size());
+
+    for (long debut = 0; debut < total; debut += taille_lot) {
+        const int n = static_cast<int>(std::min<long>(taille_lot, total - debut));
+        chemins.redimensionner(n);
+        impacts.resize(n);
+        vivant.resize(n);
+        radiance.assign(n, couleur(0, 0, 0));
+
+        for (int k = 0; k < n; k++) {
+            int p = pixel_tache[debut + k];
+            int s = echantillon_tache[debut + k];
+            int lig = tuile.y0 + static_cast<int>(p / largeur_tuile);
+            int i = tuile.x0 + static_cast<int>(p % largeur_tuile);
+            int j = (hauteur_img-1) - lig;
+
+            Echantillonneur::commencer(i, j, largeur_img, s);
+            auto [du, dv] = Echantillonneur::echantillon_2d();
+            auto u = (i + du) / (largeur_img-1);
+            auto v = (j + dv) / (hauteur_img-1);
+            chemins.definir_rayon(k, cam.getrayon(u, v));
+            chemins.debit_r[k] = chemins.debit_g[k] = chemins.debit_b[k] = 1.0;
+            chemins.pdf_prec[k] = 0;
+            chemins.echantillon[k] = k;
+            chemins.flux[k] = Random::flux();
+            chemins.contextes[k] = Echantillonneur::contexte();
+        }
+        chemins.nombre = n;
+
+        for (int profondeur = 0; profondeur < profondeur_max && chemins.nombre > 0; ++profondeur) {
+            Statistiques::locaux().ajouter(profondeur == 0 ? RayonsCamera : RayonsRebond, chemins.nombre);
+            etendre(monde, materiaux, lumieres);
+
+            // Avant toute compaction, le chemin k est encore l'echantillon k du lot
+            if (profondeur == 0 && aov != nullptr) {
+                for (int k = 0; k < n; k++)
+                    (*aov)[pixel_tache[debut + k]].ajouter(aov_premier_impact(chemins.obtenir_rayon(k), vivant[k], impacts[k], materiaux));
+            }
+
+            trier(materiaux);
+            ombrer<LambertianMateriau>(file_lambertien, monde, materiaux, lumieres, profondeur, roulette);
+            ombrer<MetalMateriau>(file_metal, monde, materiaux, lumieres, profondeur, roulette);
+            ombrer<DielectricMateriau>(file_dielectrique, monde, materiaux, lumieres, profondeur, roulette);
+            compacter();
+        }
+        // Chemins encore vivants a la profondeur maximale
+        Statistiques::locaux().ajouter(FinsProfondeur, chemins.nombre);
+
+        // Somme dans l'ordre des echantillons, pour un resultat independant de l'ordre de terminaison
+        for (int k = 0; k < n; k++) {
+            int p = pixel_tache[debut + k];
+            accumulation[p] += radiance[k];
+            carres[p] += luminance(radiance[k]) * luminance(radiance[k]);
+        }
+    }
+}
+
+void IntegrateurWavefront::etendre(const Object& monde, const TableMateriaux& materiaux, const Lumieres& lumieres) {
+    int touches = 0;
+    for (int i = 0; i < chemins.nombre; i++) {
+        rayon r = chemins.obtenir_rayon(i);
+        if (monde.intersect(r, 0.001, infinity, impacts[i])) {
+            const EnregIntersect& rec = impacts[i];
+            couleur emission = emission_ponderee(r, rec, materiaux[rec.materiau_id], lumieres,
+                point(chemins.px_prec[i], chemins.py_prec[i], chemins.pz_prec[i]), chemins.pdf_prec[i]);
+            couleur debit(chemins.debit_r[i], chemins.debit_g[i], chemins.debit_b[i]);
+            radiance[chemins.echantillon[i]] += debit * emission;
+            vivant[i] = 1;
+            touches++;
+        }
+        else {
+            // Le rayon s'echappe : on recolte le ciel pondere par le debit du chemin
+            couleur debit(chemins.debit_r[i], chemins.debit_g[i], chemins.debit_b[i]);
+            radiance[chemins.echantillon[i]] += debit * couleur_ciel(r);
+            vivant[i] = 0;
+        }
+    }
+
+    CompteursThread& compteurs = Statistiques::locaux();
+    compteurs.ajouter(Touches, touches);
+    compteurs.ajouter(Rates, chemins.nombre - touches);
+    compteurs.ajouter(FinsCiel, chemins.nombre - touches);
+}
+
+void IntegrateurWavefront::trier(const TableMateriaux& materiaux) {
+    file_lambertien.clear();
+    file_metal.clear();
+    file_dielectrique.clear();
+
+    for (int i = 0; i < chemins.nombre; i++) {
+        if (!vivant[i]) continue;
+        switch (materiaux[impacts[i].materiau_id].type()) {
+            case TypeMateriau::Lambertien:   file_lambertien.push_back(i); break;
+            case TypeMateriau::Metal:        file_metal.push_back(i); break;
+            case TypeMateriau::Dielectrique: file_dielectrique.push_back(i); break;
+            // Une source absorbe le chemin ; son emission a ete recoltee par etendre()
+            case TypeMateriau::Emissif:
+                vivant[i] = 0;
+                Statistiques::locaux().ajouter(FinsAbsorption);
+                break;
+        }
+    }
+}
+
+template <class M>
+void IntegrateurWavefront::ombrer(const std::vector<int>& file, const Object& monde, const TableMateriaux& materiaux,
+                                  const Lumieres& lumieres, int profondeur, const RouletteRusse& roulette) {
+    couleur attenuation;
+    rayon interactionR;
+    couleur f;
+    CompteursThread& compteurs = Statistiques::locaux();
+
+    for (int i : file) {
+        const EnregIntersect& rec = impacts[i];
+        const M* mat = static_cast<const M*>(&materiaux[rec.materiau_id]);
+        rayon r = chemins.obtenir_rayon(i);
+        couleur debit(chemins.debit_r[i], chemins.debit_g[i], chemins.debit_b[i]);
+
+        Random::flux() = chemins.flux[i];
+        Echantillonneur::contexte() = chemins.contextes[i];
+        Echantillonneur::commencer_lumiere(profondeur);
+        radiance[chemins.echantillon[i]] += debit * lumiere_directe(r, rec, *mat, monde, materiaux, lumieres);
+
+        Echantillonneur::commencer_rebond(profondeur);
+        // Appel qualifie : pas de dispatch virtuel, toute la file suit le meme code
+        if (mat->M::intercation(r, rec, attenuation, interactionR)) {
+            if (!mat->M::evaluer(rec, interactionR.direction(), f, chemins.pdf_prec[i]))
+                chemins.pdf_prec[i] = 0;
+            chemins.px_prec[i] = rec.p.x();
+            chemins.py_prec[i] = rec.p.y();
+            chemins.pz_prec[i] = rec.p.z();
+
+            debit = debit * attenuation;
+            if (roulette.survit(profondeur, debit)) {
+                chemins.definir_rayon(i, interactionR);
+                chemins.debit_r[i] = debit.x();
+                chemins.debit_g[i] = debit.y();
+                chemins.debit_b[i] = debit.z();
+            }
+            else {
+                vivant[i] = 0;
+                compteurs.ajouter(FinsRoulette);
+            }
+        }
+        else {
+            vivant[i] = 0;
+            compteurs.ajouter(FinsAbsorption);
+        }
+        chemins.flux[i] = Random::flux();
+    }
+}
+
+void IntegrateurWavefront::compacter() {
+    int j = 0;
+    for (int i = 0; i < chemins.nombre; i++) {
+        if (!vivant[i]) continue;
+        if (i != j) chemins.copier(j, i);
+        j++;
+    }
+    chemins.nombre = j;
+}
+
+#endif // INTEGRATEURWAVEFRONT_H_INCLUDED
@@ -0,0 +1,203 @@
+#ifndef LUMIERES_H_INCLUDED
+#define LUMIERES_H_INCLUDED
+
+#include <vector>
+#include <memory>
+#include <algorithm>
+
+#include "rt.h"
+#include "vecteur3.h"
+#include "rayon.h"
+#include "ObjectHit.h"
+#include "sphere.h"
+#include "Mobile_Sphere.h"
+#include "SoupeSpheres.h"
+#include "materiau.h"
+#include "Echantillonneur.h"
+#include "Statistiques.h"
+
+// Sphere emissive ; le centre varie lineairement avec le temps, comme dans la soupe de spheres
+struct LumiereSphere {
+    point centre0;
+    vecteur3 vitesse;
+    double temps0;
+    double rayon;
+    uint32_t materiau_id;
+    uint32_t primitive_id;
+
+    point centre(double temps) const { return centre0 + (temps - temps0) * vitesse; }
+};
+
+// Heuristique de la puissance de Veach (beta = 2)
+inline double heuristique_puissance(double pdf_a, double pdf_b) {
+    double a2 = pdf_a * pdf_a, b2 = pdf_b * pdf_b;
+    return a2 + b2 > 0 ? a2 / (a2 + b2) : 0;
+}
+
+// Lumieres de la scene, echantillonnees par angle solide : depuis un point, on tire une
+// direction uniforme dans le cone sous-tendu par la sphere choisie.
+class Lumieres {
+public:
+    // A appeler apres l'indexation des materiaux et des primitives
+    void construire(const std::vector<shared_ptr<Object>>& objets, const TableMateriaux& materiaux);
+
+    // Meme chose pour une scene binaire, dont les spheres ne sont que dans la soupe
+    void construire(const SoupeSpheres& soupe, const TableMateriaux& materiaux);
+
+    bool vide() const { return spheres.empty(); }
+
+    // Indice de la lumiere portee par une primitive, -1 si elle n'emet pas
+    int lumiere_de(uint32_t primitive_id) const {
+        return primitive_id < par_primitive.size() ? par_primitive[primitive_id] : -1;
+    }
+
+    // Choisit une lumiere puis une direction vers elle (3 dimensions de l'echantillonneur).
+    // `pdf` est la densite en angle solide, choix de la lumiere compris ; `distance` celle du point vise.
+    bool echantillonner(const point& p, double temps, vecteur3& direction, double& distance, double& pdf, int& indice) const;
+
+    // Densite avec laquelle echantillonner() produit une direction donnee vers la lumiere `indice`
+    double pdf(int indice, const point& p, double temps) const;
+
+public:
+    std::vector<LumiereSphere> spheres;
+
+private:
+    // 1 - cos(demi-angle du cone), 0 si le point est dans la sphere
+    static double ouverture(const LumiereSphere& l, const point& p, double temps, double& cos_max);
+
+    // Retient la sphere si son materiau emet
+    void ajouter(const LumiereSphere& l, const TableMateriaux& materiaux);
+
+    std::vector<int> par_primitive;
+};
+
+void Lumieres::construire(const std::vector<shared_ptr<Object>>& objets, const TableMateriaux& materiaux) {
+    spheres.clear();
+    par_primitive.clear();
+
+    for (const auto& obj : objets) {
+        LumiereSphere l;
+        if (auto s = dynamic_cast<const SphereObject*>(obj.get())) {
+            l = {s->center, vecteur3(0, 0, 0), 0.0, s->radius, s->materiau_id, s->primitive_id};
+        }
+        else if (auto m = dynamic_cast<const Mobile_Sphere*>(obj.get())) {
+            vecteur3 vitesse = m->time1 > m->time0 ? (m->center1 - m->center0) / (m->time1 - m->time0) : vecteur3(0, 0, 0);
+            l = {m->center0, vitesse, m->time0, m->radius, m->materiau_id, m->primitive_id};
+        }
+        else {
+            continue;
+        }
+        ajouter(l, materiaux);
+    }
+}
+
+void Lumieres::construire(const SoupeSpheres& soupe, const TableMateriaux& materiaux) {
+    spheres.clear();
+    par_primitive.clear();
+
+    for (int i = 0; i < soupe.nombre(); i++) {
+        ajouter({point(soupe.cx[i], soupe.cy[i], soupe.cz[i]), vecteur3(soupe.vx[i], soupe.vy[i], soupe.vz[i]), 0.0,
+                 soupe.rayons[i], soupe.materiaux_id[i], soupe.primitives_id[i]}, materiaux);
+    }
+}
+
+void Lumieres::ajouter(const LumiereSphere& l, const TableMateriaux& materiaux) {
+    if (materiaux[l.materiau_id].emis().norme2() <= 0) return;
+
+    if (par_primitive.size() <= l.primitive_id)
+        par_primitive.resize(l.primitive_id + 1, -1);
+    par_primitive[l.primitive_id] = static_cast<int>(spheres.size());
+    spheres.push_back(l);
+}
+
+double Lumieres::ouverture(const LumiereSphere& l, const point& p, double temps, double& cos_max) {
+    double d2 = (l.centre(temps) - p).norme2();
+    double r2 = l.rayon * l.rayon;
+    if (d2 <= r2) return 0;
+
+    double sin2_max = r2 / d2;
+    cos_max = sqrt(1 - sin2_max);
+    // 1 - cos_max sans annulation pour les lumieres petites ou lointaines
+    return sin2_max / (1 + cos_max);
+}
+
+bool Lumieres::echantillonner(const point& p, double temps, vecteur3& direction, double& distance, double& pdf, int& indice) const {
+    if (spheres.empty()) return false;
+
+    const int n = static_cast<int>(spheres.size());
+    indice = std::min(n - 1, static_cast<int>(Echantillonneur::echantillon_1d() * n));
+    auto [u1, u2] = Echantillonneur::echantillon_2d();
+
+    const LumiereSphere& l = spheres[indice];
+    double cos_max;
+    double un_moins_cos_max = ouverture(l, p, temps, cos_max);
+    if (un_moins_cos_max <= 0) return false;
+
+    vecteur3 axe = vecteur_unitaire(l.centre(temps) - p);
+    vecteur3 tangente, bitangente;
+    base_orthonormee(axe, tangente, bitangente);
+
+    double cos_theta = 1 - u1 * un_moins_cos_max;
+    double sin_theta = sqrt(fmax(0.0, 1 - cos_theta * cos_theta));
+    double phi = 2 * pi * u2;
+    direction = cos_theta * axe + sin_theta * cos(phi) * tangente + sin_theta * sin(phi) * bitangente;
+
+    // Premiere intersection avec la sphere le long de la direction tiree
+    vecteur3 oc = p - l.centre(temps);
+    double b = produit_scalaire(oc, direction);
+    double discriminant = b * b - (oc.norme2() - l.rayon * l.rayon);
+    distance = -b - sqrt(fmax(0.0, discriminant));
+
+    pdf = 1.0 / (n * 2 * pi * un_moins_cos_max);
+    return distance > 0;
+}
+
+double Lumieres::pdf(int indice, const point& p, double temps) const {
+    double cos_max;
+    double un_moins_cos_max = ouverture(spheres[indice], p, temps, cos_max);
+    if (un_moins_cos_max <= 0) return 0;
+    return 1.0 / (spheres.size() * 2 * pi * un_moins_cos_max);
+}
+
+// Eclairage direct a un impact par une lumiere echantillonnee, pondere par MIS avec
+// l'echantillonnage de la BSDF. Le debit du chemin n'est pas inclus.
+couleur lumiere_directe(const rayon& r, const EnregIntersect& rec, const materiau& mat, const Object& monde,
+                        const TableMateriaux& materiaux, const Lumieres& lumieres) {
+    vecteur3 direction;
+    double distance, pdf_lumiere;
+    int indice;
+    if (lumieres.vide() || !lumieres.echantillonner(rec.p, r.temps(), direction, distance, pdf_lumiere, indice))
+        return couleur(0, 0, 0);
+
+    couleur f;
+    double pdf_bsdf;
+    if (!mat.evaluer(rec, direction, f, pdf_bsdf))
+        return couleur(0, 0, 0);
+
+    // La lumiere elle-meme est a `distance` : on s'arrete juste avant
+    CompteursThread& compteurs = Statistiques::locaux();
+    compteurs.ajouter(RayonsOmbre);
+    bool cache = monde.occluded(rayon(rec.p, direction, r.temps()), 0.001, distance * (1 - 1e-6));
+    compteurs.ajouter(cache ? Touches : Rates);
+    if (cache)
+        return couleur(0, 0, 0);
+
+    couleur emission = materiaux[lumieres.spheres[indice].materiau_id].emis();
+    return f * emission * (heuristique_puissance(pdf_lumiere, pdf_bsdf) / pdf_lumiere);
+}
+
+// Emission vue par un chemin qui touche une surface ; `pdf_bsdf_prec` vaut 0 si le sommet
+// precedent etait la camera ou un materiau speculaire (la lumiere n'y a pas ete echantillonnee)
+couleur emission_ponderee(const rayon& r, const EnregIntersect& rec, const materiau& mat, const Lumieres& lumieres,
+                          const point& p_prec, double pdf_bsdf_prec) {
+    couleur emission = mat.emis();
+    if (pdf_bsdf_prec <= 0 || emission.norme2() <= 0)
+        return emission;
+
+    int indice = lumieres.lumiere_de(rec.primitive_id);
+    if (indice < 0)
+        return emission;
+    return emission * heuristique_puissance(pdf_bsdf_prec, lumieres.pdf(indice, p_prec, r.temps()));
+}
+
+#endif // LUMIERES_H_INCLUDED
@@ -1,280 +1,1302 @@
-#ifndef MOTEURDERENDU_H_INCLUDED
-#define MOTEURDERENDU_H_INCLUDED
-#include <SFML/Graphics.hpp>
-#include <ostream>
-#include <iostream>
-#include <omp.h>
-#include <vector>
-#include <chrono>
-#include "ObjectList.h"
-#include "couleur.h"
-#include "vecteur3.h"
-#include "rayon.h"
-#include "rt.h"
-#include "camera.h"
-#include "materiau.h"
-
-class MoteurRendu {
-private:
-    sf::Texture texture;
-
-    int largeur_img;
-    int hauteur_img;
-    std::vector<sf::Uint8> pixels;
-    int echantillons_par_pixel;
-    double rapport_aspect;
-    int profondeur_max;
-    ObjectList monde;
-    camera cam;
-    bool image_pret=false;
-
-    // Variables pour activer la barre de progression
-    bool en_travail = false;
-    int lignes_restantes = 0;
-    std::chrono::time_point<std::chrono::steady_clock> temps_debut;
-
-public:
-    MoteurRendu();
-
-    MoteurRendu(const MoteurRendu&);
-
-    MoteurRendu(unsigned int largeur_image, unsigned int hauteur_image,
-               int echantillons_par_pixel = 50,
-               int profondeur_max = 20);
-
-    MoteurRendu(const char* nom_fichier_xml);
-
-    void sauvegarderDocumentXml(const char* nom_fichier) const;
-
-    void creerImage();
-
-    void rendreImage();
-
-    void rendreImage(sf::Texture&);
-
-    void rendreImage(int nouvelle_largeur_img, int nouvelle_hauteur_img);
-
-    void rendreImage(sf::Texture&, int nouvelle_largeur_img, int nouvelle_hauteur_img);
-
-    void definirEchantillonsParPixel(int valeur) {
-        echantillons_par_pixel = valeur;
-    }
-
-    void definirProfondeurMax(int valeur) {
-        profondeur_max = valeur;
-    }
-
-    void definirRapportAspect(double valeur) {
-        rapport_aspect = valeur;
-        hauteur_img = static_cast<int>(largeur_img / rapport_aspect);
-    }
-
-    void definirLargeurImage(int valeur) {
-        largeur_img = valeur;
-        rapport_aspect = static_cast<double>(largeur_img / hauteur_img);
-    }
-
-    void definirHauteurImage(int valeur) {
-        hauteur_img = valeur;
-        rapport_aspect = static_cast<double>(largeur_img / hauteur_img);
-    }
-
-    void commencerTravail() {
-        en_travail = true;
-    }
-
-    bool aImagePret() { return image_pret; }
-    sf::Texture& obtenirTexture() { return texture; }
-    int obtenirLargeurImage() { return largeur_img; }
-    int obtenirHauteurImage() { return hauteur_img; }
-
-    // Mthodes utiles pour la barre de progression
-    bool estEnTravail() { return en_travail; }
-    std::chrono::time_point<std::chrono::steady_clock> obtenirTempsDebutTravail() { return temps_debut; }
-    int obtenirLignesRestantes() { return lignes_restantes; }
-
-    void definircamera( point regarde_de,
-        point regarde_vers,
-        vecteur   vertical,
-        double champ_de_vision, // angle de champ vertical en degrs
-        double ouverture_diaphragme,
-        double distance_de_focus,double temps0 = 0,
-        double temps1 = 0) {
-            cam = camera(regarde_de, regarde_vers, vertical, champ_de_vision, rapport_aspect, ouverture_diaphragme,
-                distance_de_focus, temps0, temps1);
-        }
-
-    void ajouterAuMonde(std::shared_ptr<Object> objet) {
-        monde.ajouter(objet);
-    }
-};
-
-MoteurRendu::MoteurRendu() : largeur_img(480), hauteur_img(400), pixels(4*largeur_img*hauteur_img),
-    echantillons_par_pixel(100), profondeur_max(50) {
-        texture = sf::Texture();
-        texture.create(largeur_img, hauteur_img);
-        rapport_aspect = (double) largeur_img/hauteur_img;
-        point regarde_de(13,2,3);
-        point regarde_vers(0,0,0);
-
-        vecteur vertical(0,1,0);
-
-        auto distance_de_focus = 10.0;
-        auto ouverture_diaphragme = 0.1;
-
-        cam = camera(regarde_de, regarde_vers, vertical, 20.0, rapport_aspect, ouverture_diaphragme, distance_de_focus, 0.0, 1.0);
-        monde = scene_aleatoire();
-    }
-
-MoteurRendu::MoteurRendu(unsigned int largeur_image, unsigned int hauteur_image,
-               int echantillons_par_pixel,
-               int profondeur_max) :
-    largeur_img(largeur_image), hauteur_img(hauteur_image), pixels(largeur_img*hauteur_img*4),
-    echantillons_par_pixel(echantillons_par_pixel), rapport_aspect(largeur_img / hauteur_img), profondeur_max(profondeur_max), monde(), cam()  {
-
-        texture = sf::Texture();
-        texture.create(largeur_img, hauteur_img);
-    }
-
-MoteurRendu::MoteurRendu(const char* nom_fichier) {
-    tinyxml2::XMLDocument xmlDoc;
-
-    tinyxml2::XMLError eResult = xmlDoc.LoadFile(nom_fichier);
-    //XMLCheckResult(eResult);
-
-    tinyxml2::XMLNode * pRoot = xmlDoc.FirstChild();
-    if (pRoot == nullptr) throw std::invalid_argument("Le fichier ne contient pas d'lment racine");
-
-    tinyxml2::XMLElement * pElement = pRoot->FirstChildElement("MoteurRendu");
-    if (pElement == nullptr) throw std::invalid_argument("Le fichier ne contient pas d'lment moteur de rendu");
-
-    largeur_img = pElement->IntAttribute("LargeurImg");
-    hauteur_img = pElement->IntAttribute("HauteurImg");
-    echantillons_par_pixel = pElement->IntAttribute("EchantillonsParPixel");
-    rapport_aspect = pElement->DoubleAttribute("RapportAspect");
-    profondeur_max = pElement->IntAttribute("ProfondeurMax");
-
-    pixels = std::vector<sf::Uint8>(4*largeur_img*hauteur_img);
-    texture = sf::Texture();
-    texture.create(largeur_img, hauteur_img);
-
-    tinyxml2::XMLElement * pElementcamera = pElement->FirstChildElement("camera");
-    if (pElementcamera == nullptr) throw std::invalid_argument("Le fichier ne contient pas d'lment camera");
-
-    cam = camera(pElementcamera);
-
-    tinyxml2::XMLElement * pElementListe = pRoot->FirstChildElement("Liste");
-    if (pElementListe == nullptr) throw std::invalid_argument("Le fichier ne contient pas d'lment liste");
-
-    monde = ObjectList(pElementListe);
-}
-
-void MoteurRendu::sauvegarderDocumentXml(const char* nom_fichier) const{
-    tinyxml2::XMLDocument xmlDoc;
-
-    tinyxml2::XMLNode * pRoot = xmlDoc.NewElement("Racine");
-    xmlDoc.InsertFirstChild(pRoot);
-
-    tinyxml2::XMLElement * pElement = xmlDoc.NewElement("MoteurRendu");
-
-    pElement->SetAttribute("LargeurImg", largeur_img);
-    pElement->SetAttribute("HauteurImg", hauteur_img);
-    pElement->SetAttribute("EchantillonsParPixel", echantillons_par_pixel);
-    pElement->SetAttribute("RapportAspect", rapport_aspect);
-    pElement->SetAttribute("ProfondeurMax", profondeur_max);
-
-    pElement->InsertEndChild(cam.to_xml(xmlDoc));
-    pRoot->InsertEndChild(pElement);
-
-    pRoot->InsertEndChild(monde.to_xml(xmlDoc));
-
-    xmlDoc.SaveFile(nom_fichier);
-}
-
-// Retourne la couleur d'un rayon
-couleur couleur_rayon(const rayon& r, const ObjectList& monde, int profondeur) {
-    EnregIntersect rec;
-
-    // Si nous avons dpass la limite de rebonds du rayon, plus de lumire n'est collecte.
-    if (profondeur <= 0)
-        return couleur(0,0,0);
-
-    if (monde.impact(r, 0.001, infini, rec)) {
-        rayon interactionR;
-        couleur attenuation;
-
-        if (rec.materiau_ptr->interaction(r, rec, attenuation, interactionR))
-            return attenuation * couleur_rayon(interactionR, monde, profondeur-1);
-        return couleur(0,0,0);
-    }
-    vecteur direction_unite = vecteur_unitaire(r.direction());
-    auto t = 0.5*(direction_unite.y() + 1.0);
-    return (1.0-t)*couleur(1.0, 1.0, 1.0) + t*couleur(0.5, 0.7, 1.0);
-}
-
-void MoteurRendu::creerImage()
-{
-    if (en_travail) {
-        // Rendu
-        pixels.clear();
-        start_time = std::chrono::steady_clock::now();
-        for (int j = hauteur_img-1; j >= 0; --j) {
-            lignes_restantes = j;
-            #pragma omp parallel for schedule(dynamic, 10)
-            for (int i = 0; i < largeur_img; ++i) {
-                couleur couleur_pixel(0, 0, 0);
-                for (int s = 0; s < echantillons_par_pixel; ++s) {
-                    auto u = (i + random_double()) / (largeur_img-1);
-                    auto v = (j + random_double()) / (hauteur_img-1);
-                    rayon r = cam.obtenirrayon(u, v);
-                    couleur_pixel += couleur_rayon(r, monde, profondeur_max);
-                }
-                ecrire_couleur(pixels, couleur_pixel, echantillons_par_pixel, (hauteur_img-1) - j, i, largeur_img);
-            }
-        }
-        en_travail = false;
-        image_pret = true;
-    }
-}
-
-void MoteurRendu::rendreImage() {
-    creerImage();
-    texture.create(largeur_img, hauteur_img);
-    texture.update(pixels.data());
-}
-
-void MoteurRendu::rendreImage(sf::Texture& nouvelle_texture) {
-    texture = nouvelle_texture;
-    rendreImage();
-}
-
-void MoteurRendu::rendreImage(int nouvelle_largeur_img, int nouvelle_hauteur_img) {
-    if (hauteur_img != nouvelle_hauteur_img || largeur_img != nouvelle_largeur_img) {
-        hauteur_img = nouvelle_hauteur_img;
-        largeur_img = nouvelle_largeur_img;
-
-        pixels.resize(hauteur_img*largeur_img*4);
-    }
-
-    rendreImage();
-}
-
-void MoteurRendu::rendreImage(sf::Texture& nouvelle_texture, int nouvelle_largeur_img, int nouvelle_hauteur_img) {
-    if (hauteur_img != nouvelle_hauteur_img || largeur_img != nouvelle_largeur_img) {
-        hauteur_img = nouvelle_hauteur_img;
-        largeur_img = nouvelle_largeur_img;
-
-        pixels.resize(hauteur_img*largeur_img*4);
-    }
-    texture = nouvelle_texture;
-
-    rendreImage();
-}
-
-
-
-
-
-
-
-#endif // MOTEURDERENDU_H_INCLUDED
+#ifndef MOTEURDERENDU_H_INCLUDED
+#define MOTEURDERENDU_H_INCLUDED
+#include <SFML/Graphics.hpp>
+#include <ostream>
+#include <iostream>
+#include <vector>
+#include <chrono>
+#include <mutex>
+#include <atomic>
+#include <functional>
+#include <numeric>
+#include "ObjectList.h"
+#include "BVH.h"
+#include "OrdonnanceurTuiles.h"
+#include "IntegrateurWavefront.h"
+#include "Lumieres.h"
+#include "couleur.h"
+#include "ImageHDR.h"
+#include "Debruiteur.h"
+#include "Sequence.h"
+#include "Reprojection.h"
+#include "SceneBinaire.h"
+#include "Statistiques.h"
+#include "Trace.h"
+#include "vecteur3.h"
+#include "rayon.h"
+#include "rt.h"
+#include "camera.h"
+#include "materiau.h"
+
+// Structure d'acceleration utilisee pour le monde au moment du rendu
+enum class TypeAccelerateur { Liste, BVH };
+
+// Etat partage entre le thread de rendu et le thread d'affichage
+struct SynchroRendu {
+    std::mutex verrou_pixels;
+    std::atomic<bool> en_travail{false};   // un rendu est demande ou en cours
+    std::atomic<bool> image_pret{false};   // les tampons contiennent une image terminee
+    std::atomic<bool> nouvelle_passe{false};
+    std::atomic<bool> interrompre{false};
+    std::atomic<int> passes_terminees{0};
+    std::atomic<int> passes_totales{1};
+    // Debut et fin du dernier rendu, en ticks de steady_clock : lus par l'interface pendant le rendu
+    std::atomic<int64_t> debut_rendu{0};
+    std::atomic<int64_t> fin_rendu{0};
+};
+
+inline int64_t ticks_maintenant() {
+    return std::chrono::steady_clock::now().time_since_epoch().count();
+}
+
+class MoteurRendu {
+private:
+    sf::Texture texture;
+
+    int largeur_img;
+    int hauteur_img;
+    std::vector<sf::Uint8> pixels;
+
+    // Sommes de radiance (RVB) et nombre d'echantillons par pixel, accumulees au fil des passes
+    std::vector<float> accumulation;
+    std::vector<uint32_t> echantillons_pixel;
+    int echantillons_par_passe = 0; // 0 : une seule passe
+
+    // Echantillonnage adaptatif : on n'echantillonne plus les pixels dont l'erreur relative
+    // estimee passe sous le seuil (0 : desactive), sans depasser echantillons_max par pixel
+    double seuil_adaptatif = 0;
+    int echantillons_max = 0;
+    std::vector<double> luminance_carres;
+    std::vector<uint8_t> pixels_actifs;
+
+    // Sommes par pixel des donnees du premier impact (albedo et normale RVB, profondeur), guides du debruiteur
+    bool collecter_aov = false;
+    std::vector<float> aov_albedo, aov_normale, aov_profondeur;
+    ParametresDebruitage debruitage;
+
+    ParametresSequence sequence;
+    // Image de la sequence en cours de rendu ; decale la graine pour que le bruit change d'une image a l'autre
+    int image_sequence = 0;
+
+    // Accumulation temporelle : guides du premier impact, historique des images precedentes,
+    // radiance melangee (vide sans accumulation) et budget d'echantillons de chaque pixel
+    ParametresTemporel temporel;
+    HistoriqueTemporel historique;
+    std::vector<GuidePixel> guides;
+    std::vector<float> radiance_temporelle;
+    std::vector<uint32_t> budget_pixel;
+    std::vector<vecteur3> vitesses_primitives;
+
+    // Cout par pixel, 3 canaux sommes sur toutes les passes : cycles, tests d'intersection, rebonds
+    bool collecter_cout = false;
+    std::vector<float> cout_pixel;
+
+    int echantillons_par_pixel;
+    double rapport_aspect;
+    int profondeur_max;
+    RouletteRusse roulette;
+    ObjectList monde;
+    // Scene chargee depuis un fichier .rtsb : ses spheres ne sont pas dans `monde`
+    std::shared_ptr<SceneBinaire> scene_binaire;
+    shared_ptr<Object> accelerateur;
+    // Faux tant que `accelerateur` a ete construit sur le monde actuel
+    bool monde_modifie = true;
+    TableMateriaux materiaux;
+    Lumieres lumieres;
+    TypeAccelerateur type_accelerateur = TypeAccelerateur::BVH;
+    TypeIntegrateur type_integrateur = TypeIntegrateur::Recursif;
+    TypeEchantillonneur type_echantillonneur = TypeEchantillonneur::Sobol;
+    ParametresResolution resolution;
+    camera cam;
+    uint64_t graine = 0;
+
+    // Pool de threads persistant, partage entre les copies du moteur
+    std::shared_ptr<PoolTuiles> pool;
+    int nombre_threads = 0;
+    int taille_tuile = 32;
+
+    std::shared_ptr<SynchroRendu> synchro = std::make_shared<SynchroRendu>();
+
+    // Appele par le thread de rendu apres chaque passe, une fois l'image resolue
+    std::function<void(int)> rappel_passe;
+
+    void remplirDocumentXml(tinyxml2::XMLDocument& xmlDoc) const;
+
+public:
+    MoteurRendu();
+
+    MoteurRendu(const MoteurRendu&);
+
+    MoteurRendu(unsigned int largeur_image, unsigned int hauteur_image,
+               int echantillons_par_pixel = 50,
+               int profondeur_max = 20);
+
+    // Charge une scene XML, ou une scene binaire si l'extension est .rtsb
+    MoteurRendu(const char* nom_fichier);
+
+    void sauvegarderDocumentXml(const char* nom_fichier) const;
+
+    // Scene complete en texte XML, et moteur relu depuis ce texte (envoi de la scene a un noeud de calcul)
+    std::string documentXml() const;
+    static MoteurRendu depuisDocumentXml(const std::string& texte);
+
+    // Empreinte (FNV-1a) de la scene, de la camera et des reglages de l'estimateur, sans la graine,
+    // le nombre d'echantillons, l'affichage (exposition, debruitage...) ni l'implementation
+    // (accelerateur, integrateur) : deux rendus de meme empreinte estiment la meme image
+    uint64_t empreinteScene() const;
+
+    // Convertit la scene au format binaire (.rtsb), BVH compris
+    bool sauvegarderSceneBinaire(const char* nom_fichier);
+
+    // Choisit le format d'apres l'extension
+    bool sauvegarderScene(const char* nom_fichier);
+
+    // Lit et ecrit les attributs de l'element <MoteurRendu> (camera, debruitage, sequence et accumulation temporelle compris)
+    void lireParametres(tinyxml2::XMLElement* pElement);
+    tinyxml2::XMLElement* parametresXml(tinyxml2::XMLDocument& xmlDoc) const;
+
+    void construireAccelerateur();
+
+    void creerImage();
+
+    // Rendu par regions, pour le calcul distribue. Les regions sont en coordonnees de l'image
+    // entiere : un pixel recoit les memes echantillons que dans un rendu complet.
+    // commencerRegions() remet les tampons a zero (et prepare l'accelerateur si ce moteur rend
+    // lui-meme), rendreRegion() rend une region ici, extraireRegion() et integrerRegion()
+    // la transportent d'un moteur a l'autre, terminerRegions() resout l'image assemblee.
+    void commencerRegions(bool rendre);
+    void rendreRegion(const Tuile& zone);
+    bool regionValide(const Tuile& zone) const;
+    // Flottants par pixel d'une region extraite : radiance, echantillons, puis AOV et cout s'ils sont collectes
+    int canauxRegion() const;
+    std::vector<float> extraireRegion(const Tuile& zone) const;
+    bool integrerRegion(const Tuile& zone, const std::vector<float>& donnees);
+    void terminerRegions();
+
+    // Enregistre l'image depuis le tampon de pixels, sans passer par la texture (aucun contexte graphique requis).
+    // Les extensions .pfm et .exr enregistrent la radiance moyenne, avant exposition et tonemap.
+    bool sauvegarderImage(const char* nom_fichier) const;
+
+    // Radiance moyenne par pixel (RVB flottant, lignes de haut en bas)
+    std::vector<float> obtenirRadiance() const;
+
+    // Radiance moyenne, debruitee si le debruitage est actif et que les guides ont ete collectes
+    std::vector<float> obtenirImageFinale() const;
+
+    // Moyenne par pixel d'une somme a `canaux` composantes
+    std::vector<float> moyenneParPixel(const std::vector<float>& somme, int canaux) const;
+
+    // Enregistre albedo, normale et profondeur en <prefixe>_albedo.pfm, <prefixe>_normale.pfm et <prefixe>_profondeur.pfm
+    bool sauvegarderAOV(const std::string& prefixe) const;
+
+    // <prefixe>_cout.pfm (cycles, tests, rebonds par pixel) et <prefixe>_cout.png (carte des cycles)
+    bool sauvegarderCout(const std::string& prefixe) const;
+
+    // Ajoute au plus `nombre_echantillons` echantillons a chaque pixel actif de la tuile, sans depasser `budget`
+    void rendreTuile(const Tuile& tuile, int nombre_echantillons, int budget);
+
+    // Desactive les pixels de `zone` dont l'erreur estimee est sous le seuil, ainsi que ceux qui ont atteint le budget
+    void mettreAJourPixelsActifs(int budget, const Tuile& zone);
+
+    // Remet a zero les tampons d'accumulation de toute l'image
+    void preparerTampons();
+
+    // Accelerateur, graine, pool de threads et echantillonneur, avant de rendre des tuiles
+    void preparerRendu();
+    void preparerPool();
+
+    // Nombre maximal d'echantillons par pixel, et echantillons ajoutes par passe
+    int budgetPixel() const;
+    int echantillonsParPasse(int budget) const;
+
+    // Passes d'echantillonnage sur `tuiles`, toutes comprises dans `zone`
+    void executerPasses(const std::vector<Tuile>& tuiles, const Tuile& zone, int budget, int par_passe, bool publier);
+
+    // Lance un rayon sans ouverture par centre de pixel a l'instant `temps` et remplit `guides`
+    void calculerGuides(const std::vector<Tuile>& tuiles, double temps);
+
+    // Convertit l'accumulation en pixels affichables
+    void resoudreImage();
+
+    // A appeler depuis le thread qui possede le contexte graphique ; renvoie true si une nouvelle passe a ete publiee
+    bool mettreAJourTexture();
+
+    // Demande l'arret du rendu a la fin de la passe en cours
+    void interrompre() { synchro->interrompre = true; }
+
+    void rendreImage();
+
+    void rendreImage(sf::Texture&);
+
+    void rendreImage(int nouvelle_largeur_img, int nouvelle_hauteur_img);
+
+    void rendreImage(sf::Texture&, int nouvelle_largeur_img, int nouvelle_hauteur_img);
+
+    void definirEchantillonsParPixel(int valeur) {
+        echantillons_par_pixel = valeur;
+    }
+
+    int obtenirEchantillonsParPixel() const { return echantillons_par_pixel; }
+
+    void definirProfondeurMax(int valeur) {
+        profondeur_max = valeur;
+    }
+
+    void definirRoulette(int profondeur_min, double survie_max) {
+        roulette.profondeur_min = profondeur_min;
+        roulette.survie_max = survie_max;
+    }
+
+    // 0 : un thread par coeur
+    void definirNombreThreads(int valeur) {
+        nombre_threads = valeur;
+    }
+
+    void definirGraine(uint64_t valeur) {
+        graine = valeur;
+    }
+    uint64_t obtenirGraine() const { return graine; }
+
+    void definirAccelerateur(TypeAccelerateur valeur) {
+        type_accelerateur = valeur;
+        monde_modifie = true;
+    }
+
+    // Nombre d'echantillons par pixel entre deux affichages ; 0 pour tout rendre en une passe
+    void definirEchantillonsParPasse(int valeur) {
+        echantillons_par_passe = valeur;
+    }
+
+    void definirSeuilAdaptatif(double valeur) {
+        seuil_adaptatif = valeur;
+    }
+
+    void definirEchantillonsMax(int valeur) {
+        echantillons_max = valeur;
+    }
+
+    // Change l'exposition, le tonemap ou le gamma ; une image deja rendue est resolue a nouveau sans relancer le rendu
+    void definirResolution(const ParametresResolution& valeur) {
+        resolution = valeur;
+        if (synchro->image_pret) {
+            resoudreImage();
+            synchro->nouvelle_passe = true;
+        }
+    }
+
+    const ParametresResolution& obtenirResolution() const { return resolution; }
+
+    // Comme pour la resolution, une image deja rendue est debruitee a nouveau sans relancer le rendu
+    void definirDebruitage(const ParametresDebruitage& valeur) {
+        debruitage = valeur;
+        if (synchro->image_pret) {
+            resoudreImage();
+            synchro->nouvelle_passe = true;
+        }
+    }
+
+    const ParametresDebruitage& obtenirDebruitage() const { return debruitage; }
+
+    void definirSequence(const ParametresSequence& valeur) {
+        sequence = valeur;
+    }
+
+    const ParametresSequence& obtenirSequence() const { return sequence; }
+
+    // Sans accumulation, l'historique est oublie
+    void definirTemporel(const ParametresTemporel& valeur) {
+        temporel = valeur;
+        if (!temporel.actif) historique.vider();
+    }
+
+    const ParametresTemporel& obtenirTemporel() const { return temporel; }
+
+    // Intervalle d'obturation de la camera, celui de la scene hors sequence
+    double obtenirDebutObturation() const { return cam.getStartTime(); }
+    double obtenirFinObturation() const { return cam.getEndTime(); }
+
+    void definirObturation(double debut, double fin) {
+        cam.setShutter(debut, fin);
+    }
+
+    // Prepare le rendu de l'image `image` de la sequence : son intervalle d'obturation et sa graine.
+    // Le monde, le pool et l'accelerateur restent en place ; le BVH n'est que reajuste.
+    void definirImageSequence(int image) {
+        image_sequence = image;
+        definirObturation(sequence.debut(image), sequence.fin(image));
+    }
+
+    // Suivi de la convergence (bancs d'essai) : `rappel(passe)` s'execute sur le thread de rendu
+    void definirRappelPasse(std::function<void(int)> rappel) {
+        rappel_passe = std::move(rappel);
+    }
+
+    // Nombre d'echantillons accumules dans toute l'image
+    uint64_t obtenirEchantillonsTotal() const {
+        return std::accumulate(echantillons_pixel.begin(), echantillons_pixel.end(), uint64_t(0));
+    }
+
+    // Collecte les guides meme sans debruitage (pour les enregistrer, ou pour debruiter apres coup)
+    void definirCollecteAOV(bool valeur) {
+        collecter_aov = valeur;
+    }
+
+    // Mesure le cout de rendu de chaque pixel (carte de chaleur, repartition des tuiles)
+    void definirCollecteCout(bool valeur) {
+        collecter_cout = valeur;
+    }
+    bool obtenirCollecteAOV() const { return collecter_aov; }
+    bool obtenirCollecteCout() const { return collecter_cout; }
+
+    const std::vector<float>& obtenirCoutPixels() const { return cout_pixel; }
+
+    void definirEchantillonneur(TypeEchantillonneur valeur) {
+        type_echantillonneur = valeur;
+    }
+
+    void definirIntegrateur(TypeIntegrateur valeur) {
+        type_integrateur = valeur;
+    }
+
+    void definirRapportAspect(double valeur) {
+        rapport_aspect = valeur;
+        hauteur_img = static_cast<int>(largeur_img / rapport_aspect);
+    }
+
+    void definirLargeurImage(int valeur) {
+        largeur_img = valeur;
+        rapport_aspect = static_cast<double>(largeur_img / hauteur_img);
+    }
+
+    void definirHauteurImage(int valeur) {
+        hauteur_img = valeur;
+        rapport_aspect = static_cast<double>(largeur_img / hauteur_img);
+    }
+
+    void commencerTravail() {
+        synchro->en_travail = true;
+    }
+
+    bool aImagePret() { return synchro->image_pret; }
+    sf::Texture& obtenirTexture() { return texture; }
+    int obtenirLargeurImage() const { return largeur_img; }
+    int obtenirHauteurImage() const { return hauteur_img; }
+
+    // Méthodes utiles pour la barre de progression
+    bool estEnTravail() { return synchro->en_travail; }
+    std::chrono::time_point<std::chrono::steady_clock> obtenirTempsDebutTravail() {
+        return std::chrono::time_point<std::chrono::steady_clock>(std::chrono::steady_clock::duration(synchro->debut_rendu));
+    }
+
+    // Duree du rendu en cours, ou du dernier rendu termine, en secondes
+    double obtenirDureeRendu() const {
+        const int64_t fin = synchro->en_travail ? ticks_maintenant() : synchro->fin_rendu.load();
+        return std::max(0.0, std::chrono::duration<double>(std::chrono::steady_clock::duration(fin - synchro->debut_rendu)).count());
+    }
+
+    int obtenirNombreThreads() const {
+        return pool ? pool->nombreThreads() : (nombre_threads > 0 ? nombre_threads : static_cast<int>(std::max(1u, std::thread::hardware_concurrency())));
+    }
+    int obtenirLignesRestantes() {
+        if (!pool || pool->tuilesTotales() == 0) return 0;
+        // Avancement global : passes terminees plus la fraction de la passe en cours
+        long total = static_cast<long>(synchro->passes_totales) * pool->tuilesTotales();
+        long restant = static_cast<long>(synchro->passes_totales - synchro->passes_terminees - 1) * pool->tuilesTotales()
+                       + pool->tuilesRestantes();
+        return static_cast<int>(hauteur_img * std::max(0L, restant) / total);
+    }
+
+    void definircamera( point regarde_de,
+        point regarde_vers,
+        vecteur   vertical,
+        double champ_de_vision, // angle de champ vertical en degrés
+        double ouverture_diaphragme,
+        double distance_de_focus,double temps0 = 0,
+        double temps1 = 0) {
+            cam = camera(regarde_de, regarde_vers, vertical, champ_de_vision, rapport_aspect, ouverture_diaphragme,
+                distance_de_focus, temps0, temps1);
+        }
+
+    void ajouterAuMonde(std::shared_ptr<Object> objet) {
+        // Une scene binaire redevient une liste d'objets pour pouvoir etre modifiee
+        if (scene_binaire) {
+            monde = scene_binaire->vers_liste();
+            scene_binaire.reset();
+        }
+        monde.ajouter(objet);
+        monde_modifie = true;
+        historique.vider();
+    }
+};
+
+MoteurRendu::MoteurRendu() : largeur_img(480), hauteur_img(400), pixels(4*largeur_img*hauteur_img),
+    echantillons_par_pixel(100), profondeur_max(50) {
+        rapport_aspect = (double) largeur_img/hauteur_img;
+        point regarde_de(13,2,3);
+        point regarde_vers(0,0,0);
+
+        vecteur vertical(0,1,0);
+
+        auto distance_de_focus = 10.0;
+        auto ouverture_diaphragme = 0.1;
+
+        cam = camera(regarde_de, regarde_vers, vertical, 20.0, rapport_aspect, ouverture_diaphragme, distance_de_focus, 0.0, 1.0);
+        monde = scene_aleatoire();
+    }
+
+MoteurRendu::MoteurRendu(unsigned int largeur_image, unsigned int hauteur_image,
+               int echantillons_par_pixel,
+               int profondeur_max) :
+    largeur_img(largeur_image), hauteur_img(hauteur_image), pixels(largeur_img*hauteur_img*4),
+    echantillons_par_pixel(echantillons_par_pixel), rapport_aspect(largeur_img / hauteur_img), profondeur_max(profondeur_max), monde(), cam()  {
+    }
+
+MoteurRendu::MoteurRendu(const char* nom_fichier) {
+    PorteeTrace trace("chargement scene");
+    tinyxml2::XMLDocument xmlDoc;
+
+    // Scene binaire : seuls les parametres sont en XML, les spheres restent dans le fichier projete
+    if (est_scene_binaire(nom_fichier)) {
+        scene_binaire = SceneBinaire::ouvrir(nom_fichier);
+        const std::string parametres = scene_binaire->parametres();
+        if (xmlDoc.Parse(parametres.data(), parametres.size()) != tinyxml2::XML_SUCCESS || xmlDoc.FirstChildElement("MoteurRendu") == nullptr)
+            throw std::invalid_argument("La scene binaire ne contient pas d'élément moteur de rendu");
+        lireParametres(xmlDoc.FirstChildElement("MoteurRendu"));
+        return;
+    }
+
+    tinyxml2::XMLError eResult = xmlDoc.LoadFile(nom_fichier);
+    //XMLCheckResult(eResult);
+
+    tinyxml2::XMLNode * pRoot = xmlDoc.FirstChild();
+    if (pRoot == nullptr) throw std::invalid_argument("Le fichier ne contient pas d'élément racine");
+
+    tinyxml2::XMLElement * pElement = pRoot->FirstChildElement("MoteurRendu");
+    if (pElement == nullptr) throw std::invalid_argument("Le fichier ne contient pas d'élément moteur de rendu");
+
+    lireParametres(pElement);
+
+    // Les listes ecrites par ObjectList::to_xml s'appellent "ObjectList"
+    tinyxml2::XMLElement * pElementListe = pRoot->FirstChildElement("Liste");
+    if (pElementListe == nullptr) pElementListe = pRoot->FirstChildElement("ObjectList");
+    if (pElementListe == nullptr) throw std::invalid_argument("Le fichier ne contient pas d'élément liste");
+
+    monde = ObjectList(pElementListe);
+}
+
+std::string MoteurRendu::documentXml() const {
+    tinyxml2::XMLDocument xmlDoc;
+    remplirDocumentXml(xmlDoc);
+    tinyxml2::XMLPrinter printer;
+    xmlDoc.Print(&printer);
+    return printer.CStr();
+}
+
+uint64_t MoteurRendu::empreinteScene() const {
+    tinyxml2::XMLDocument xmlDoc;
+    remplirDocumentXml(xmlDoc);
+    tinyxml2::XMLElement * pElement = xmlDoc.FirstChildElement()->FirstChildElement("MoteurRendu");
+    for (const char* attribut : {"Graine", "EchantillonsParPixel", "EchantillonsParPasse", "EchantillonsMax", "SeuilAdaptatif",
+                                 "Exposition", "Tonemap", "Gamma", "Accelerateur", "Integrateur"})
+        pElement->DeleteAttribute(attribut);
+    // L'obturation de l'image d'une sequence est deja dans la camera
+    for (const char* enfant : {"Debruitage", "Sequence", "Temporel"}) {
+        if (tinyxml2::XMLElement* e = pElement->FirstChildElement(enfant))
+            pElement->DeleteChild(e);
+    }
+    tinyxml2::XMLPrinter printer;
+    xmlDoc.Print(&printer);
+
+    uint64_t empreinte = 0xcbf29ce484222325ULL;
+    for (const char* c = printer.CStr(); *c != '\0'; c++)
+        empreinte = (empreinte ^ static_cast<unsigned char>(*c)) * 0x100000001b3ULL;
+    return empreinte;
+}
+
+MoteurRendu MoteurRendu::depuisDocumentXml(const std::string& texte) {
+    tinyxml2::XMLDocument xmlDoc;
+    if (xmlDoc.Parse(texte.data(), texte.size()) != tinyxml2::XML_SUCCESS || xmlDoc.FirstChild() == nullptr)
+        throw std::invalid_argument("Le document ne contient pas d'élément racine");
+
+    tinyxml2::XMLElement * pElement = xmlDoc.FirstChild()->FirstChildElement("MoteurRendu");
+    tinyxml2::XMLElement * pElementListe = xmlDoc.FirstChild()->FirstChildElement("ObjectList");
+    if (pElement == nullptr || pElementListe == nullptr)
+        throw std::invalid_argument("Le document ne contient pas d'élément moteur de rendu ou liste");
+
+    MoteurRendu moteur(1, 1);
+    moteur.lireParametres(pElement);
+    moteur.monde = ObjectList(pElementListe);
+    return moteur;
+}
+
+void MoteurRendu::lireParametres(tinyxml2::XMLElement* pElement) {
+    largeur_img = pElement->IntAttribute("LargeurImg");
+    hauteur_img = pElement->IntAttribute("HauteurImg");
+    echantillons_par_pixel = pElement->IntAttribute("EchantillonsParPixel");
+    echantillons_par_passe = pElement->IntAttribute("EchantillonsParPasse");
+    seuil_adaptatif = pElement->DoubleAttribute("SeuilAdaptatif");
+    echantillons_max = pElement->IntAttribute("EchantillonsMax");
+    rapport_aspect = pElement->DoubleAttribute("RapportAspect");
+    profondeur_max = pElement->IntAttribute("ProfondeurMax");
+    roulette.profondeur_min = pElement->IntAttribute("ProfondeurRoulette", roulette.profondeur_min);
+    roulette.survie_max = pElement->DoubleAttribute("SurvieMaxRoulette", roulette.survie_max);
+    graine = pElement->Unsigned64Attribute("Graine");
+    const char* accel = pElement->Attribute("Accelerateur");
+    if (accel != nullptr && strcmp(accel, "Liste") == 0)
+        type_accelerateur = TypeAccelerateur::Liste;
+    const char* integ = pElement->Attribute("Integrateur");
+    if (integ != nullptr && strcmp(integ, "Wavefront") == 0)
+        type_integrateur = TypeIntegrateur::Wavefront;
+    type_echantillonneur = echantillonneur_depuis_nom(pElement->Attribute("Echantillonneur"));
+    resolution.exposition = pElement->DoubleAttribute("Exposition");
+    resolution.tonemap = tonemap_depuis_nom(pElement->Attribute("Tonemap"));
+    resolution.gamma = pElement->DoubleAttribute("Gamma");
+
+    pixels = std::vector<sf::Uint8>(4*largeur_img*hauteur_img);
+
+    tinyxml2::XMLElement * pElementcamera = pElement->FirstChildElement("camera");
+    if (pElementcamera == nullptr) throw std::invalid_argument("Le fichier ne contient pas d'élément camera");
+
+    cam = camera(pElementcamera);
+
+    tinyxml2::XMLElement * pElementDebruitage = pElement->FirstChildElement("Debruitage");
+    if (pElementDebruitage != nullptr)
+        debruitage = ParametresDebruitage(pElementDebruitage);
+
+    tinyxml2::XMLElement * pElementSequence = pElement->FirstChildElement("Sequence");
+    if (pElementSequence != nullptr)
+        sequence = ParametresSequence(pElementSequence);
+
+    tinyxml2::XMLElement * pElementTemporel = pElement->FirstChildElement("Temporel");
+    if (pElementTemporel != nullptr)
+        temporel = ParametresTemporel(pElementTemporel);
+}
+
+void MoteurRendu::sauvegarderDocumentXml(const char* nom_fichier) const{
+    tinyxml2::XMLDocument xmlDoc;
+    remplirDocumentXml(xmlDoc);
+    xmlDoc.SaveFile(nom_fichier);
+}
+
+void MoteurRendu::remplirDocumentXml(tinyxml2::XMLDocument& xmlDoc) const {
+    tinyxml2::XMLNode * pRoot = xmlDoc.NewElement("Racine");
+    xmlDoc.InsertFirstChild(pRoot);
+
+    pRoot->InsertEndChild(parametresXml(xmlDoc));
+
+    if (scene_binaire)
+        pRoot->InsertEndChild(scene_binaire->vers_liste().to_xml(xmlDoc));
+    else
+        pRoot->InsertEndChild(monde.to_xml(xmlDoc));
+}
+
+tinyxml2::XMLElement* MoteurRendu::parametresXml(tinyxml2::XMLDocument& xmlDoc) const {
+    tinyxml2::XMLElement * pElement = xmlDoc.NewElement("MoteurRendu");
+
+    pElement->SetAttribute("LargeurImg", largeur_img);
+    pElement->SetAttribute("HauteurImg", hauteur_img);
+    pElement->SetAttribute("EchantillonsParPixel", echantillons_par_pixel);
+    pElement->SetAttribute("EchantillonsParPasse", echantillons_par_passe);
+    pElement->SetAttribute("SeuilAdaptatif", seuil_adaptatif);
+    pElement->SetAttribute("EchantillonsMax", echantillons_max);
+    pElement->SetAttribute("RapportAspect", rapport_aspect);
+    pElement->SetAttribute("ProfondeurMax", profondeur_max);
+    pElement->SetAttribute("ProfondeurRoulette", roulette.profondeur_min);
+    pElement->SetAttribute("SurvieMaxRoulette", roulette.survie_max);
+    pElement->SetAttribute("Graine", graine);
+    pElement->SetAttribute("Accelerateur", type_accelerateur == TypeAccelerateur::Liste ? "Liste" : "BVH");
+    pElement->SetAttribute("Integrateur", type_integrateur == TypeIntegrateur::Wavefront ? "Wavefront" : "Recursif");
+    pElement->SetAttribute("Echantillonneur", nom_echantillonneur(type_echantillonneur));
+    pElement->SetAttribute("Exposition", resolution.exposition);
+    pElement->SetAttribute("Tonemap", nom_tonemap(resolution.tonemap));
+    pElement->SetAttribute("Gamma", resolution.gamma);
+
+    pElement->InsertEndChild(cam.to_xml(xmlDoc));
+    pElement->InsertEndChild(debruitage.to_xml(xmlDoc));
+    if (sequence.actif)
+        pElement->InsertEndChild(sequence.to_xml(xmlDoc));
+    if (temporel.actif)
+        pElement->InsertEndChild(temporel.to_xml(xmlDoc));
+    return pElement;
+}
+
+bool MoteurRendu::sauvegarderSceneBinaire(const char* nom_fichier) {
+    tinyxml2::XMLDocument xmlDoc;
+    xmlDoc.InsertFirstChild(parametresXml(xmlDoc));
+    tinyxml2::XMLPrinter printer;
+    xmlDoc.Print(&printer);
+
+    // Le BVH est construit pour l'intervalle d'obturation de la camera, comme au rendu
+    TableMateriaux table;
+    shared_ptr<BVH> bvh;
+    if (scene_binaire) {
+        scene_binaire->indexer(table);
+        bvh = make_shared<BVH>(*scene_binaire->soupe(), cam.getStartTime(), cam.getEndTime());
+    }
+    else {
+        uint32_t prochaine_primitive = 0;
+        monde.indexer(table, prochaine_primitive);
+        bvh = make_shared<BVH>(monde, cam.getStartTime(), cam.getEndTime());
+    }
+    return ecrire_scene_binaire(nom_fichier, printer.CStr(), table, *bvh, cam.getStartTime(), cam.getEndTime());
+}
+
+bool MoteurRendu::sauvegarderScene(const char* nom_fichier) {
+    PorteeTrace trace("enregistrement scene");
+    if (est_scene_binaire(nom_fichier))
+        return sauvegarderSceneBinaire(nom_fichier);
+    sauvegarderDocumentXml(nom_fichier);
+    return true;
+}
+
+void MoteurRendu::construireAccelerateur() {
+    PorteeTrace trace("construction accelerateur");
+    materiaux.vider();
+
+    // Scene binaire : les materiaux sont deja indexes et le BVH est repris tel quel, ses boites
+    // etant recalculees s'il a ete construit pour un autre intervalle de temps.
+    // Le type d'accelerateur n'y change rien.
+    if (scene_binaire) {
+        const EnteteSceneBinaire& entete = scene_binaire->entete();
+        scene_binaire->indexer(materiaux);
+
+        shared_ptr<SoupeSpheres> soupe = scene_binaire->soupe();
+        lumieres.construire(*soupe, materiaux);
+        if (temporel.actif) {
+            // Identifiants verifies par SceneBinaire::ouvrir ; l'ecriture reste tout de meme bornee a la table
+            vitesses_primitives.assign(soupe->nombre(), vecteur3(0, 0, 0));
+            for (int i = 0; i < soupe->nombre(); i++) {
+                if (soupe->primitives_id[i] < vitesses_primitives.size())
+                    vitesses_primitives[soupe->primitives_id[i]] = vecteur3(soupe->vx[i], soupe->vy[i], soupe->vz[i]);
+            }
+        }
+        auto bvh = make_shared<BVH>(scene_binaire->noeuds(), scene_binaire->boites_fin(),
+                                    static_cast<int>(entete.nombre_noeuds), soupe, entete.temps0, entete.temps1);
+        if (entete.temps0 != cam.getStartTime() || entete.temps1 != cam.getEndTime())
+            bvh->ajuster(cam.getStartTime(), cam.getEndTime());
+        accelerateur = bvh;
+        return;
+    }
+
+    // Les identifiants doivent etre attribues avant la construction : la soupe du BVH les recopie
+    uint32_t prochaine_primitive = 0;
+    monde.indexer(materiaux, prochaine_primitive);
+    lumieres.construire(monde.objects, materiaux);
+    if (temporel.actif) {
+        vitesses_primitives.assign(prochaine_primitive, vecteur3(0, 0, 0));
+        for (const auto& obj : monde.objects) {
+            auto m = dynamic_cast<const Mobile_Sphere*>(obj.get());
+            if (m != nullptr && m->time1 > m->time0)
+                vitesses_primitives[m->primitive_id] = (m->center1 - m->center0) / (m->time1 - m->time0);
+        }
+    }
+
+    // Meme monde qu'au rendu precedent : l'arbre est garde et ses boites suivent l'obturation.
+    // Un BVH partage avec une copie du moteur est reconstruit plutot que modifie sous elle.
+    if (!monde_modifie && accelerateur.use_count() == 1) {
+        auto bvh = std::dynamic_pointer_cast<BVH>(accelerateur);
+        if (bvh && (bvh->temps_debut() != cam.getStartTime() || bvh->temps_fin() != cam.getEndTime()))
+            bvh->ajuster(cam.getStartTime(), cam.getEndTime());
+        return;
+    }
+
+    if (type_accelerateur == TypeAccelerateur::BVH)
+        accelerateur = make_shared<BVH>(monde, cam.getStartTime(), cam.getEndTime());
+    else
+        accelerateur = make_shared<ObjectList>(monde);
+    monde_modifie = false;
+}
+
+// Retourne la couleur d'un rayon
+couleur couleur_rayon(const rayon& r, const Object& monde, const TableMateriaux& materiaux, const Lumieres& lumieres,
+                      int profondeur_max, const RouletteRusse& roulette, EchantillonAOV* aov = nullptr) {
+    EnregIntersect rec;
+    couleur radiance(0,0,0);
+    couleur debit(1,1,1);
+    rayon courant = r;
+
+    // Sommet precedent et densite de la direction qui en part, pour ponderer les lumieres touchees
+    point p_prec;
+    double pdf_bsdf_prec = 0;
+
+    CompteursThread& compteurs = Statistiques::locaux();
+
+    // Au-delà de la limite de rebonds du rayon, plus de lumière n'est collectée.
+    for (int profondeur = 0; profondeur < profondeur_max; ++profondeur) {
+        compteurs.ajouter(profondeur == 0 ? RayonsCamera : RayonsRebond);
+        bool touche = monde.intersect(courant, 0.001, infinity, rec);
+        compteurs.ajouter(touche ? Touches : Rates);
+        if (profondeur == 0 && aov != nullptr)
+            *aov = aov_premier_impact(courant, touche, rec, materiaux);
+        if (!touche) {
+            compteurs.ajouter(FinsCiel);
+            return radiance + debit * couleur_ciel(courant);
+        }
+
+        const materiau& mat = materiaux[rec.materiau_id];
+        radiance += debit * emission_ponderee(courant, rec, mat, lumieres, p_prec, pdf_bsdf_prec);
+
+        Echantillonneur::commencer_lumiere(profondeur);
+        radiance += debit * lumiere_directe(courant, rec, mat, monde, materiaux, lumieres);
+
+        rayon interactionR;
+        couleur attenuation;
+        Echantillonneur::commencer_rebond(profondeur);
+        if (!mat.intercation(courant, rec, attenuation, interactionR)) {
+            compteurs.ajouter(FinsAbsorption);
+            return radiance;
+        }
+
+        couleur f;
+        if (!mat.evaluer(rec, interactionR.direction(), f, pdf_bsdf_prec))
+            pdf_bsdf_prec = 0;
+        p_prec = rec.p;
+
+        debit = debit * attenuation;
+        if (!roulette.survit(profondeur, debit)) {
+            compteurs.ajouter(FinsRoulette);
+            return radiance;
+        }
+        courant = interactionR;
+    }
+    compteurs.ajouter(FinsProfondeur);
+    return radiance;
+}
+
+void MoteurRendu::creerImage()
+{
+    if (synchro->en_travail) {
+        PorteeTrace trace("creerImage");
+        // Rendu
+        preparerTampons();
+        preparerRendu();
+        const int budget = budgetPixel();
+        const int par_passe = echantillonsParPasse(budget);
+
+        synchro->interrompre = false;
+        synchro->passes_terminees = 0;
+        synchro->passes_totales = (budget + par_passe - 1) / par_passe;
+
+        // Les compteurs ne portent que sur ce rendu ; les threads du pool sont au repos
+        Statistiques::remettre_a_zero();
+        synchro->debut_rendu = ticks_maintenant();
+        const std::vector<Tuile> tuiles = decouper_en_tuiles(largeur_img, hauteur_img, taille_tuile);
+
+        // Accumulation temporelle : un pixel ou l'image precedente se reprojette ne recoit que les
+        // echantillons qui manquent a son historique pour atteindre le budget (au moins
+        // temporel.echantillons), et l'historique complete sa moyenne a la fin du rendu
+        const double temps_image = 0.5 * (cam.getStartTime() + cam.getEndTime());
+        std::vector<float> reprojection, poids_reprojection;
+        radiance_temporelle.clear();
+        budget_pixel.clear();
+        if (temporel.actif) {
+            PorteeTrace trace_reprojection("reprojection");
+            calculerGuides(tuiles, temps_image);
+            historique.reprojeter(guides, temps_image, largeur_img, hauteur_img, temporel, reprojection, poids_reprojection);
+            if (!poids_reprojection.empty()) {
+                const uint32_t reduit = static_cast<uint32_t>(std::clamp(temporel.echantillons, 1, budget));
+                budget_pixel.resize(largeur_img*hauteur_img);
+                for (size_t k = 0; k < budget_pixel.size(); ++k)
+                    budget_pixel[k] = poids_reprojection[k] > 0
+                        ? std::max(reduit, static_cast<uint32_t>(std::max(0.0f, budget - std::min(poids_reprojection[k], temporel.historique_max))))
+                        : static_cast<uint32_t>(budget);
+            }
+        }
+
+        executerPasses(tuiles, Tuile{0, 0, largeur_img, hauteur_img}, budget, par_passe, true);
+
+        if (temporel.actif) {
+            PorteeTrace trace_melange("accumulation temporelle");
+            std::vector<float> poids;
+            melanger_historique(accumulation, echantillons_pixel, reprojection, poids_reprojection, largeur_img, hauteur_img,
+                                temporel, radiance_temporelle, poids);
+            // Une image interrompue n'a pas tous ses echantillons : elle ne sert pas d'historique
+            if (synchro->interrompre)
+                historique.vider();
+            else
+                historique.memoriser(radiance_temporelle, std::move(poids), guides, cam, temps_image, largeur_img, hauteur_img);
+            resoudreImage();
+            synchro->nouvelle_passe = true;
+        }
+
+        synchro->fin_rendu = ticks_maintenant();
+        synchro->en_travail = false;
+        synchro->image_pret = true;
+    }
+}
+
+void MoteurRendu::commencerRegions(bool rendre) {
+    PorteeTrace trace("commencerRegions");
+    preparerTampons();
+    radiance_temporelle.clear();
+    budget_pixel.clear();
+    // Le coordinateur n'a besoin du pool que pour le debruitage
+    if (rendre) preparerRendu();
+    else preparerPool();
+    synchro->debut_rendu = ticks_maintenant();
+    synchro->en_travail = true;
+    synchro->image_pret = false;
+}
+
+bool MoteurRendu::regionValide(const Tuile& zone) const {
+    return zone.x0 >= 0 && zone.y0 >= 0 && zone.x0 < zone.x1 && zone.y0 < zone.y1 && zone.x1 <= largeur_img && zone.y1 <= hauteur_img;
+}
+
+// L'accumulation de la region repart de zero : une region rendue deux fois n'est pas comptee double
+void MoteurRendu::rendreRegion(const Tuile& zone) {
+    PorteeTrace trace("region", "x", zone.x0, "y", zone.y0);
+    if (!regionValide(zone)) throw std::invalid_argument("Region hors de l'image");
+
+    const bool aov_actifs = !aov_profondeur.empty();
+    const bool cout_actif = !cout_pixel.empty();
+    for (int lig = zone.y0; lig < zone.y1; ++lig) {
+        const int debut = lig * largeur_img + zone.x0, fin = lig * largeur_img + zone.x1;
+        std::fill(accumulation.begin() + 3*debut, accumulation.begin() + 3*fin, 0.0f);
+        std::fill(echantillons_pixel.begin() + debut, echantillons_pixel.begin() + fin, 0);
+        std::fill(luminance_carres.begin() + debut, luminance_carres.begin() + fin, 0.0);
+        std::fill(pixels_actifs.begin() + debut, pixels_actifs.begin() + fin, 1);
+        if (aov_actifs) {
+            std::fill(aov_albedo.begin() + 3*debut, aov_albedo.begin() + 3*fin, 0.0f);
+            std::fill(aov_normale.begin() + 3*debut, aov_normale.begin() + 3*fin, 0.0f);
+            std::fill(aov_profondeur.begin() + debut, aov_profondeur.begin() + fin, 0.0f);
+        }
+        if (cout_actif)
+            std::fill(cout_pixel.begin() + 3*debut, cout_pixel.begin() + 3*fin, 0.0f);
+    }
+
+    const int budget = budgetPixel();
+    const int par_passe = echantillonsParPasse(budget);
+    synchro->interrompre = false;
+    synchro->passes_totales = (budget + par_passe - 1) / par_passe;
+    executerPasses(decouper_en_tuiles(zone, taille_tuile), zone, budget, par_passe, false);
+}
+
+int MoteurRendu::canauxRegion() const {
+    return 4 + (aov_profondeur.empty() ? 0 : 7) + (cout_pixel.empty() ? 0 : 3);
+}
+
+std::vector<float> MoteurRendu::extraireRegion(const Tuile& zone) const {
+    std::vector<float> donnees;
+    if (!regionValide(zone)) return donnees;
+    donnees.reserve(static_cast<size_t>(canauxRegion()) * (zone.x1 - zone.x0) * (zone.y1 - zone.y0));
+    for (int lig = zone.y0; lig < zone.y1; ++lig) {
+        for (int i = zone.x0; i < zone.x1; ++i) {
+            const int indice = lig * largeur_img + i;
+            donnees.insert(donnees.end(), &accumulation[3*indice], &accumulation[3*indice] + 3);
+            donnees.push_back(static_cast<float>(echantillons_pixel[indice]));
+            if (!aov_profondeur.empty()) {
+                donnees.insert(donnees.end(), &aov_albedo[3*indice], &aov_albedo[3*indice] + 3);
+                donnees.insert(donnees.end(), &aov_normale[3*indice], &aov_normale[3*indice] + 3);
+                donnees.push_back(aov_profondeur[indice]);
+            }
+            if (!cout_pixel.empty())
+                donnees.insert(donnees.end(), &cout_pixel[3*indice], &cout_pixel[3*indice] + 3);
+        }
+    }
+    return donnees;
+}
+
+// Renvoie false si la region ou la taille des donnees ne correspondent pas a ce moteur
+bool MoteurRendu::integrerRegion(const Tuile& zone, const std::vector<float>& donnees) {
+    if (!regionValide(zone) || donnees.size() != static_cast<size_t>(canauxRegion()) * (zone.x1 - zone.x0) * (zone.y1 - zone.y0))
+        return false;
+
+    const float* p = donnees.data();
+    for (int lig = zone.y0; lig < zone.y1; ++lig) {
+        for (int i = zone.x0; i < zone.x1; ++i) {
+            const int indice = lig * largeur_img + i;
+            std::copy(p, p + 3, &accumulation[3*indice]);
+            echantillons_pixel[indice] = static_cast<uint32_t>(p[3]);
+            p += 4;
+            if (!aov_profondeur.empty()) {
+                std::copy(p, p + 3, &aov_albedo[3*indice]);
+                std::copy(p + 3, p + 6, &aov_normale[3*indice]);
+                aov_profondeur[indice] = p[6];
+                p += 7;
+            }
+            if (!cout_pixel.empty()) {
+                std::copy(p, p + 3, &cout_pixel[3*indice]);
+                p += 3;
+            }
+        }
+    }
+    return true;
+}
+
+void MoteurRendu::terminerRegions() {
+    PorteeTrace trace("terminerRegions");
+    resoudreImage();
+    synchro->nouvelle_passe = true;
+    synchro->fin_rendu = ticks_maintenant();
+    synchro->en_travail = false;
+    synchro->image_pret = true;
+}
+
+void MoteurRendu::preparerTampons() {
+    pixels.resize(4*largeur_img*hauteur_img);
+    accumulation.assign(3*largeur_img*hauteur_img, 0.0f);
+    echantillons_pixel.assign(largeur_img*hauteur_img, 0);
+    luminance_carres.assign(largeur_img*hauteur_img, 0.0);
+    pixels_actifs.assign(largeur_img*hauteur_img, 1);
+    const bool aov_actifs = collecter_aov || debruitage.actif;
+    aov_albedo.assign(aov_actifs ? 3*largeur_img*hauteur_img : 0, 0.0f);
+    aov_normale.assign(aov_actifs ? 3*largeur_img*hauteur_img : 0, 0.0f);
+    aov_profondeur.assign(aov_actifs ? largeur_img*hauteur_img : 0, 0.0f);
+    cout_pixel.assign(collecter_cout ? 3*largeur_img*hauteur_img : 0, 0.0f);
+}
+
+void MoteurRendu::preparerPool() {
+    int threads_voulus = nombre_threads > 0 ? nombre_threads : static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    if (!pool || pool->nombreThreads() != threads_voulus)
+        pool = std::make_shared<PoolTuiles>(threads_voulus);
+}
+
+void MoteurRendu::preparerRendu() {
+    construireAccelerateur();
+    Random::definir_graine(graine + static_cast<uint64_t>(image_sequence));
+    preparerPool();
+    Echantillonneur::configurer(type_echantillonneur, budgetPixel());
+}
+
+// En mode adaptatif, le budget par pixel devient echantillons_max et il faut plusieurs passes pour l'estimation
+int MoteurRendu::budgetPixel() const {
+    return seuil_adaptatif > 0 && echantillons_max > 0 ? echantillons_max : echantillons_par_pixel;
+}
+
+int MoteurRendu::echantillonsParPasse(int budget) const {
+    int par_passe = echantillons_par_passe > 0 ? echantillons_par_passe : (seuil_adaptatif > 0 ? 16 : budget);
+    return std::min(par_passe, budget);
+}
+
+// Chaque passe ajoute ses echantillons a l'accumulation ; avec `publier`, l'image resolue est
+// publiee apres chacune. Le critere adaptatif ne regarde que les pixels de `zone`.
+void MoteurRendu::executerPasses(const std::vector<Tuile>& tuiles, const Tuile& zone, int budget, int par_passe, bool publier) {
+    for (int passe = 0; passe < synchro->passes_totales && !synchro->interrompre; passe++) {
+        PorteeTrace trace_passe("passe", "passe", passe);
+        std::vector<Tuile> tuiles_actives;
+        for (const Tuile& t : tuiles) {
+            bool active = false;
+            for (int lig = t.y0; lig < t.y1 && !active; ++lig)
+                for (int i = t.x0; i < t.x1 && !active; ++i)
+                    active = pixels_actifs[lig * largeur_img + i];
+            if (active) tuiles_actives.push_back(t);
+        }
+        if (tuiles_actives.empty()) break;
+
+        pool->executer(tuiles_actives, [this, par_passe, budget](const Tuile& tuile, int) {
+            PorteeTrace trace_tuile("tuile", "x", tuile.x0, "y", tuile.y0);
+            auto debut_tuile = std::chrono::steady_clock::now();
+            rendreTuile(tuile, par_passe, budget);
+            Statistiques::locaux().ajouter(TempsActifNs,
+                std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - debut_tuile).count());
+        });
+
+        if (publier) {
+            PorteeTrace trace_resolution("resolution");
+            resoudreImage();
+        }
+        {
+            PorteeTrace trace_adaptatif("pixels actifs");
+            mettreAJourPixelsActifs(budget, zone);
+        }
+        if (publier) {
+            synchro->passes_terminees++;
+            synchro->nouvelle_passe = true;
+            if (rappel_passe) rappel_passe(passe);
+        }
+    }
+}
+
+// Rend une tuile dans un tampon local, puis l'ajoute en une fois a l'accumulation
+void MoteurRendu::rendreTuile(const Tuile& tuile, int nombre_echantillons, int budget) {
+    const int largeur_tuile = tuile.x1 - tuile.x0;
+    const int nombre_pixels = largeur_tuile * (tuile.y1 - tuile.y0);
+    std::vector<couleur> somme(nombre_pixels);
+    std::vector<double> carres(nombre_pixels);
+    const bool aov_actifs = !aov_profondeur.empty();
+    std::vector<EchantillonAOV> aov(aov_actifs ? nombre_pixels : 0);
+    const bool cout_actif = !cout_pixel.empty();
+    std::vector<float> cout_tuile(cout_actif ? 3*nombre_pixels : 0);
+    CompteursThread& compteurs = Statistiques::locaux();
+    auto lire_compteur = [&compteurs](Compteur c) { return compteurs.valeurs[c].load(std::memory_order_relaxed); };
+
+    // Chaque pixel reprend la numerotation de ses echantillons la ou il l'avait laissee
+    std::vector<int> premier(nombre_pixels), nombre(nombre_pixels);
+    for (int lig = tuile.y0; lig < tuile.y1; ++lig) {
+        for (int i = tuile.x0; i < tuile.x1; ++i) {
+            int p = (lig - tuile.y0) * largeur_tuile + (i - tuile.x0);
+            int indice = lig * largeur_img + i;
+            premier[p] = echantillons_pixel[indice];
+            const int budget_p = budget_pixel.empty() ? budget : static_cast<int>(budget_pixel[indice]);
+            nombre[p] = pixels_actifs[indice] ? std::min(nombre_echantillons, budget_p - premier[p]) : 0;
+        }
+    }
+
+    if (type_integrateur == TypeIntegrateur::Wavefront) {
+        // Un integrateur par thread, pour reutiliser ses files d'un lot et d'une tuile a l'autre
+        static thread_local IntegrateurWavefront integrateur;
+        const uint64_t cycles = cout_actif ? lire_cycles() : 0;
+        const uint64_t tests = lire_compteur(TestsIntersection), rebonds = lire_compteur(RayonsRebond);
+        integrateur.rendreTuile(tuile, largeur_img, hauteur_img, premier, nombre, profondeur_max, roulette,
+                                cam, *accelerateur, materiaux, lumieres, somme, carres, aov_actifs ? &aov : nullptr);
+
+        // Les chemins sont traites par lots : le cout de la tuile est reparti selon les echantillons de chaque pixel
+        const int echantillons = std::accumulate(nombre.begin(), nombre.end(), 0);
+        if (cout_actif && echantillons > 0) {
+            const double totaux[3] = {double(lire_cycles() - cycles), double(lire_compteur(TestsIntersection) - tests),
+                                      double(lire_compteur(RayonsRebond) - rebonds)};
+            for (int p = 0; p < nombre_pixels; p++)
+                for (int c = 0; c < 3; c++)
+                    cout_tuile[3*p + c] = static_cast<float>(totaux[c] * nombre[p] / echantillons);
+        }
+    }
+    else {
+        for (int lig = tuile.y0; lig < tuile.y1; ++lig) {
+            int j = (hauteur_img-1) - lig;
+            for (int i = tuile.x0; i < tuile.x1; ++i) {
+                int p = (lig - tuile.y0) * largeur_tuile + (i - tuile.x0);
+                couleur couleur_pixel(0, 0, 0);
+                double carre = 0;
+                const uint64_t cycles = cout_actif ? lire_cycles() : 0;
+                const uint64_t tests = lire_compteur(TestsIntersection), rebonds = lire_compteur(RayonsRebond);
+                for (int s = premier[p]; s < premier[p] + nombre[p]; ++s) {
+                    Echantillonneur::commencer(i, j, largeur_img, s);
+                    auto [du, dv] = Echantillonneur::echantillon_2d();
+                    auto u = (i + du) / (largeur_img-1);
+                    auto v = (j + dv) / (hauteur_img-1);
+                    rayon r = cam.getrayon(u, v);
+                    EchantillonAOV premier_impact;
+                    couleur c = couleur_rayon(r, *accelerateur, materiaux, lumieres, profondeur_max, roulette,
+                                              aov_actifs ? &premier_impact : nullptr);
+                    couleur_pixel += c;
+                    carre += luminance(c) * luminance(c);
+                    if (aov_actifs) aov[p].ajouter(premier_impact);
+                }
+                somme[p] = couleur_pixel;
+                carres[p] = carre;
+                if (cout_actif) {
+                    cout_tuile[3*p] = static_cast<float>(lire_cycles() - cycles);
+                    cout_tuile[3*p + 1] = static_cast<float>(lire_compteur(TestsIntersection) - tests);
+                    cout_tuile[3*p + 2] = static_cast<float>(lire_compteur(RayonsRebond) - rebonds);
+                }
+            }
+        }
+    }
+
+    for (int lig = tuile.y0; lig < tuile.y1; ++lig) {
+        for (int i = tuile.x0; i < tuile.x1; ++i) {
+            int p = (lig - tuile.y0) * largeur_tuile + (i - tuile.x0);
+            int indice = lig * largeur_img + i;
+            accumulation[3*indice] += static_cast<float>(somme[p].x());
+            accumulation[3*indice + 1] += static_cast<float>(somme[p].y());
+            accumulation[3*indice + 2] += static_cast<float>(somme[p].z());
+            luminance_carres[indice] += carres[p];
+            echantillons_pixel[indice] += nombre[p];
+            if (aov_actifs) {
+                for (int c = 0; c < 3; ++c) {
+                    aov_albedo[3*indice + c] += static_cast<float>(aov[p].albedo[c]);
+                    aov_normale[3*indice + c] += static_cast<float>(aov[p].normale[c]);
+                }
+                aov_profondeur[indice] += static_cast<float>(aov[p].profondeur);
+            }
+            if (cout_actif) {
+                for (int c = 0; c < 3; ++c)
+                    cout_pixel[3*indice + c] += cout_tuile[3*p + c];
+            }
+        }
+    }
+}
+
+void MoteurRendu::mettreAJourPixelsActifs(int budget, const Tuile& zone) {
+    // Sous ce nombre d'echantillons, l'estimation de la variance n'est pas fiable
+    const uint32_t echantillons_min = 16;
+
+    std::vector<uint8_t> bruite(largeur_img*hauteur_img, 0);
+    for (int lig = zone.y0; lig < zone.y1; ++lig) {
+        for (int i = zone.x0; i < zone.x1; ++i) {
+            int indice = lig * largeur_img + i;
+            uint32_t n = echantillons_pixel[indice];
+            if (seuil_adaptatif <= 0 || n < echantillons_min) {
+                bruite[indice] = 1;
+                continue;
+            }
+            // Erreur type de la moyenne, relative a la luminance du pixel
+            double moyenne = luminance(couleur(accumulation[3*indice], accumulation[3*indice + 1], accumulation[3*indice + 2])) / n;
+            double variance = std::max(0.0, (luminance_carres[indice] / n - moyenne * moyenne) * n / (n - 1));
+            double erreur = sqrt(variance / n) / (moyenne + 1e-3);
+            bruite[indice] = erreur > seuil_adaptatif;
+        }
+    }
+
+    // Un pixel reste actif si lui ou un voisin est encore bruite : une estimation chanceuse ne suffit pas a l'arreter
+    for (int lig = zone.y0; lig < zone.y1; ++lig) {
+        for (int i = zone.x0; i < zone.x1; ++i) {
+            int indice = lig * largeur_img + i;
+            bool actif = false;
+            for (int dl = -1; dl <= 1 && !actif; ++dl)
+                for (int di = -1; di <= 1 && !actif; ++di) {
+                    int l = lig + dl, c = i + di;
+                    if (l >= zone.y0 && l < zone.y1 && c >= zone.x0 && c < zone.x1)
+                        actif = bruite[l * largeur_img + c];
+                }
+            const uint32_t budget_p = budget_pixel.empty() ? static_cast<uint32_t>(budget) : budget_pixel[indice];
+            pixels_actifs[indice] = actif && echantillons_pixel[indice] < budget_p;
+        }
+    }
+}
+
+void MoteurRendu::calculerGuides(const std::vector<Tuile>& tuiles, double temps) {
+    guides.resize(largeur_img*hauteur_img);
+    pool->executer(tuiles, [this, temps](const Tuile& tuile, int) {
+        CompteursThread& compteurs = Statistiques::locaux();
+        for (int lig = tuile.y0; lig < tuile.y1; ++lig) {
+            int j = (hauteur_img-1) - lig;
+            for (int i = tuile.x0; i < tuile.x1; ++i) {
+                GuidePixel& g = guides[lig * largeur_img + i];
+                rayon r = cam.getPinholeRay((i + 0.5) / (largeur_img-1), (j + 0.5) / (hauteur_img-1), temps);
+                EnregIntersect rec;
+                bool touche = accelerateur->intersect(r, 0.001, infinity, rec);
+                compteurs.ajouter(touche ? Touches : Rates);
+
+                vecteur3 position = touche ? rec.p : vecteur_unitaire(r.direction());
+                vecteur3 normale = touche ? rec.surface_normal : vecteur3(0, 0, 0);
+                vecteur3 vitesse = touche && rec.primitive_id < vitesses_primitives.size() ? vitesses_primitives[rec.primitive_id] : vecteur3(0, 0, 0);
+                for (int c = 0; c < 3; ++c) {
+                    g.position[c] = static_cast<float>(position[c]);
+                    g.normale[c] = static_cast<float>(normale[c]);
+                    g.vitesse[c] = static_cast<float>(vitesse[c]);
+                }
+                g.distance = touche ? static_cast<float>(rec.t * r.direction().norme()) : 0.0f;
+                g.primitive = touche ? rec.primitive_id : sans_primitive;
+            }
+        }
+    });
+}
+
+void MoteurRendu::resoudreImage() {
+    if ((debruitage.actif && !aov_profondeur.empty()) || !radiance_temporelle.empty()) {
+        std::vector<float> image = obtenirImageFinale();
+        std::lock_guard<std::mutex> l(synchro->verrou_pixels);
+        resoudre_pixels(image.data(), nullptr, largeur_img*hauteur_img, resolution, pixels.data());
+        return;
+    }
+
+    std::lock_guard<std::mutex> l(synchro->verrou_pixels);
+    resoudre_pixels(accumulation.data(), echantillons_pixel.data(), largeur_img*hauteur_img, resolution, pixels.data());
+}
+
+std::vector<float> MoteurRendu::moyenneParPixel(const std::vector<float>& somme, int canaux) const {
+    std::vector<float> moyenne(somme.size(), 0.0f);
+    for (size_t indice = 0; indice < echantillons_pixel.size(); ++indice) {
+        if (echantillons_pixel[indice] == 0) continue;
+        for (int c = 0; c < canaux; ++c)
+            moyenne[canaux*indice + c] = somme[canaux*indice + c] / echantillons_pixel[indice];
+    }
+    return moyenne;
+}
+
+std::vector<float> MoteurRendu::obtenirRadiance() const {
+    if (!radiance_temporelle.empty()) return radiance_temporelle;
+    return moyenneParPixel(accumulation, 3);
+}
+
+std::vector<float> MoteurRendu::obtenirImageFinale() const {
+    if (!debruitage.actif || aov_profondeur.empty())
+        return obtenirRadiance();
+
+    PorteeTrace trace("debruitage");
+    return debruiter(obtenirRadiance(), moyenneParPixel(aov_albedo, 3), moyenneParPixel(aov_normale, 3),
+                     moyenneParPixel(aov_profondeur, 1), largeur_img, hauteur_img, debruitage, pool.get());
+}
+
+bool MoteurRendu::sauvegarderAOV(const std::string& prefixe) const {
+    PorteeTrace trace("enregistrement AOV");
+    if (!synchro->image_pret || aov_profondeur.empty()) return false;
+
+    std::vector<float> profondeur = moyenneParPixel(aov_profondeur, 1);
+    std::vector<float> profondeur_rvb(3 * profondeur.size());
+    for (size_t i = 0; i < profondeur.size(); ++i)
+        profondeur_rvb[3*i] = profondeur_rvb[3*i + 1] = profondeur_rvb[3*i + 2] = profondeur[i];
+
+    return ecrire_pfm(prefixe + "_albedo.pfm", moyenneParPixel(aov_albedo, 3), largeur_img, hauteur_img)
+        && ecrire_pfm(prefixe + "_normale.pfm", moyenneParPixel(aov_normale, 3), largeur_img, hauteur_img)
+        && ecrire_pfm(prefixe + "_profondeur.pfm", profondeur_rvb, largeur_img, hauteur_img);
+}
+
+bool MoteurRendu::sauvegarderCout(const std::string& prefixe) const {
+    PorteeTrace trace("enregistrement cout");
+    if (!synchro->image_pret || cout_pixel.empty()) return false;
+
+    std::vector<sf::Uint8> rgba(4 * static_cast<size_t>(largeur_img) * hauteur_img);
+    carte_chaleur(cout_pixel.data(), 3, largeur_img*hauteur_img, rgba.data());
+    sf::Image image;
+    image.create(largeur_img, hauteur_img, rgba.data());
+
+    return ecrire_pfm(prefixe + "_cout.pfm", cout_pixel, largeur_img, hauteur_img)
+        && image.saveToFile(prefixe + "_cout.png");
+}
+
+bool MoteurRendu::mettreAJourTexture() {
+    if (!synchro->nouvelle_passe.exchange(false)) return false;
+
+    std::lock_guard<std::mutex> l(synchro->verrou_pixels);
+    if (texture.getSize() != sf::Vector2u(largeur_img, hauteur_img))
+        texture.create(largeur_img, hauteur_img);
+    texture.update(pixels.data());
+    return true;
+}
+
+bool MoteurRendu::sauvegarderImage(const char* nom_fichier) const {
+    PorteeTrace trace("enregistrement image");
+    if (!synchro->image_pret) return false;
+    if (est_image_hdr(nom_fichier))
+        return ecrire_image_hdr(nom_fichier, obtenirImageFinale(), largeur_img, hauteur_img);
+
+    sf::Image image;
+    image.create(largeur_img, hauteur_img, pixels.data());
+    return image.saveToFile(nom_fichier);
+}
+
+// La texture n'est creee qu'ici : seul l'affichage a besoin d'un contexte OpenGL
+void MoteurRendu::rendreImage() {
+    PorteeTrace trace("rendreImage");
+    creerImage();
+    texture.create(largeur_img, hauteur_img);
+    texture.update(pixels.data());
+}
+
+void MoteurRendu::rendreImage(sf::Texture& nouvelle_texture) {
+    texture = nouvelle_texture;
+    rendreImage();
+}
+
+void MoteurRendu::rendreImage(int nouvelle_largeur_img, int nouvelle_hauteur_img) {
+    if (hauteur_img != nouvelle_hauteur_img || largeur_img != nouvelle_largeur_img) {
+        hauteur_img = nouvelle_hauteur_img;
+        largeur_img = nouvelle_largeur_img;
+
+        pixels.resize(hauteur_img*largeur_img*4);
+    }
+
+    rendreImage();
+}
+
+void MoteurRendu::rendreImage(sf::Texture& nouvelle_texture, int nouvelle_largeur_img, int nouvelle_hauteur_img) {
+    if (hauteur_img != nouvelle_hauteur_img || largeur_img != nouvelle_largeur_img) {
+        hauteur_img = nouvelle_hauteur_img;
+        largeur_img = nouvelle_largeur_img;
+
+        pixels.resize(hauteur_img*largeur_img*4);
+    }
+    texture = nouvelle_texture;
+
+    rendreImage();
+}
+
+
+
+
+
+
+
+#endif // MOTEURDERENDU_H_INCLUDED
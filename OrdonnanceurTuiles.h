@@ -0,0 +1,179 @@
+#ifndef ORDONNANCEURTUILES_H_INCLUDED
+#define ORDONNANCEURTUILES_H_INCLUDED
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Trace.h"
+
+// Rectangle de pixels [x0, x1) x [y0, y1), en lignes d'image (0 = haut)
+struct Tuile {
+    int x0, y0, x1, y1;
+};
+
+// Tuiles de `taille` pixels de cote couvrant `zone`, a partir de son coin haut gauche
+std::vector<Tuile> decouper_en_tuiles(const Tuile& zone, int taille) {
+    std::vector<Tuile> tuiles;
+    for (int y = zone.y0; y < zone.y1; y += taille)
+        for (int x = zone.x0; x < zone.x1; x += taille)
+            tuiles.push_back({x, y, std::min(x + taille, zone.x1), std::min(y + taille, zone.y1)});
+    return tuiles;
+}
+
+std::vector<Tuile> decouper_en_tuiles(int largeur, int hauteur, int taille) {
+    return decouper_en_tuiles(Tuile{0, 0, largeur, hauteur}, taille);
+}
+
+// Pool de threads persistant. Chaque thread a sa propre file de tuiles, qu'il consomme
+// par l'avant ; quand elle est vide, il vole les tuiles a l'arriere des files des autres.
+class PoolTuiles {
+public:
+    // 0 : un thread par coeur
+    explicit PoolTuiles(int nombre_threads = 0);
+    ~PoolTuiles();
+
+    PoolTuiles(const PoolTuiles&) = delete;
+    PoolTuiles& operator=(const PoolTuiles&) = delete;
+
+    // Distribue les tuiles aux threads et bloque jusqu'a ce qu'elles soient toutes traitees
+    void executer(const std::vector<Tuile>& tuiles, std::function<void(const Tuile&, int)> travail);
+
+    int nombreThreads() const { return static_cast<int>(threads.size()); }
+    int tuilesRestantes() const { return restantes.load(std::memory_order_relaxed); }
+    int tuilesTotales() const { return totales; }
+
+private:
+    // Une file par thread, sur sa propre ligne de cache
+    struct alignas(64) FileTuiles {
+        std::mutex verrou;
+        std::deque<Tuile> tuiles;
+    };
+
+    void boucleThread(int indice);
+    bool prendre(int indice, Tuile& tuile);
+
+    std::vector<std::thread> threads;
+    std::vector<std::unique_ptr<FileTuiles>> files;
+
+    std::mutex verrou;
+    std::condition_variable cv_travail;
+    std::condition_variable cv_fini;
+    std::function<void(const Tuile&, int)> travail_courant;
+    std::exception_ptr erreur;
+    unsigned long generation = 0;
+    int threads_actifs = 0;
+    bool arret = false;
+
+    std::atomic<int> restantes{0};
+    int totales = 0;
+};
+
+PoolTuiles::PoolTuiles(int nombre_threads) {
+    if (nombre_threads <= 0)
+        nombre_threads = std::max(1u, std::thread::hardware_concurrency());
+
+    for (int i = 0; i < nombre_threads; i++)
+        files.push_back(std::make_unique<FileTuiles>());
+    for (int i = 0; i < nombre_threads; i++)
+        threads.emplace_back(&PoolTuiles::boucleThread, this, i);
+}
+
+PoolTuiles::~PoolTuiles() {
+    {
+        std::lock_guard<std::mutex> l(verrou);
+        arret = true;
+    }
+    cv_travail.notify_all();
+    for (auto& t : threads)
+        t.join();
+}
+
+void PoolTuiles::executer(const std::vector<Tuile>& tuiles, std::function<void(const Tuile&, int)> travail) {
+    std::unique_lock<std::mutex> l(verrou);
+
+    // Chaque thread recoit une bande contigue de tuiles voisines ; le vol equilibre la fin du rendu
+    const int n = static_cast<int>(tuiles.size());
+    const int nombre_threads = nombreThreads();
+    for (int k = 0; k < nombre_threads; k++) {
+        std::lock_guard<std::mutex> lf(files[k]->verrou);
+        files[k]->tuiles.assign(tuiles.begin() + static_cast<long>(n) * k / nombre_threads,
+                                tuiles.begin() + static_cast<long>(n) * (k + 1) / nombre_threads);
+    }
+
+    totales = n;
+    restantes.store(n);
+    travail_courant = std::move(travail);
+    erreur = nullptr;
+    threads_actifs = nombre_threads;
+    generation++;
+    cv_travail.notify_all();
+
+    cv_fini.wait(l, [this] { return threads_actifs == 0; });
+    travail_courant = nullptr;
+
+    if (erreur)
+        std::rethrow_exception(erreur);
+}
+
+bool PoolTuiles::prendre(int indice, Tuile& tuile) {
+    {
+        FileTuiles& propre = *files[indice];
+        std::lock_guard<std::mutex> l(propre.verrou);
+        if (!propre.tuiles.empty()) {
+            tuile = propre.tuiles.front();
+            propre.tuiles.pop_front();
+            return true;
+        }
+    }
+
+    const int nombre_threads = nombreThreads();
+    for (int k = 1; k < nombre_threads; k++) {
+        FileTuiles& victime = *files[(indice + k) % nombre_threads];
+        std::lock_guard<std::mutex> l(victime.verrou);
+        if (!victime.tuiles.empty()) {
+            tuile = victime.tuiles.back();
+            victime.tuiles.pop_back();
+            return true;
+        }
+    }
+    return false;
+}
+
+void PoolTuiles::boucleThread(int indice) {
+    Trace::nommer_thread("tuiles " + std::to_string(indice));
+    unsigned long generation_vue = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> l(verrou);
+            cv_travail.wait(l, [&] { return arret || generation != generation_vue; });
+            if (arret) return;
+            generation_vue = generation;
+        }
+
+        Tuile tuile;
+        while (prendre(indice, tuile)) {
+            try {
+                travail_courant(tuile, indice);
+            }
+            catch (...) {
+                std::lock_guard<std::mutex> l(verrou);
+                if (!erreur) erreur = std::current_exception();
+            }
+            restantes.fetch_sub(1, std::memory_order_relaxed);
+        }
+
+        std::lock_guard<std::mutex> l(verrou);
+        if (--threads_actifs == 0)
+            cv_fini.notify_all();
+    }
+}
+
+#endif // ORDONNANCEURTUILES_H_INCLUDED
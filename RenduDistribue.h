@@ -0,0 +1,516 @@
+#ifndef RENDUDISTRIBUE_H_INCLUDED
+#define RENDUDISTRIBUE_H_INCLUDED
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "MoteurDeRendu.h"
+#include "OrdonnanceurTuiles.h"
+#include "Trace.h"
+
+// Rendu d'une image sur plusieurs processus, sur la meme machine ou non. Le coordinateur
+// charge la scene, la decoupe en regions et les confie aux noeuds de calcul connectes,
+// quelques-unes d'avance pour chacun. Un noeud rend ses regions avec MoteurRendu et renvoie
+// les sommes d'echantillons ; le coordinateur les recopie dans son image.
+// Une region d'un noeud deconnecte repart dans la file ; une region en cours depuis bien plus
+// longtemps que la moyenne est aussi confiee a un autre noeud, le premier resultat l'emporte.
+//
+// Adresses : "unix:/chemin" pour une socket Unix, "hote:port" ou ":port" en TCP.
+// Les messages sont dans l'ordre des octets de la machine : tous les noeuds doivent l'avoir en commun.
+
+struct OptionsDistribue {
+    std::string adresse;
+    int taille_region = 64;          // cote des regions, en pixels
+    int regions_d_avance = 2;        // regions confiees a un noeud en plus de celle qu'il rend
+    double facteur_lenteur = 3;      // au-dela de facteur_lenteur x la duree moyenne, une region est doublee
+    double attente_noeuds = 30;      // secondes sans aucun noeud avant d'abandonner (coordinateur)
+    double attente_connexion = 10;   // secondes pour joindre le coordinateur (noeud)
+    int threads = 0;                 // threads d'un noeud ; 0 : un par coeur
+};
+
+enum class TypeMessage : uint32_t { Scene = 1, Region = 2, Resultat = 3, Fin = 4 };
+
+const uint32_t magie_distribue = 0x31445452;  // "RTD1"
+const uint64_t taille_message_max = uint64_t(1) << 32;
+
+struct EnteteMessage {
+    uint32_t magie;
+    uint32_t type;
+    uint64_t taille;  // octets qui suivent l'entete
+};
+
+// Scene : drapeaux de collecte puis texte XML
+struct MessageScene {
+    uint32_t collecte_aov;
+    uint32_t collecte_cout;
+};
+
+// Region : seule ; Resultat : suivie des flottants de MoteurRendu::extraireRegion
+struct MessageRegion {
+    int32_t numero;
+    int32_t x0, y0, x1, y1;
+};
+
+// Sur TCP, une connexion dont l'hote a disparu sans la fermer est declaree morte apres
+// une trentaine de secondes de silence, au lieu de bloquer indefiniment recv() ou send()
+void surveiller_connexion(int fd) {
+    int un = 1, inactivite = 10, intervalle = 5, sondes = 3;
+    unsigned int delai_ms = 30000;
+    setsockopt(fd, SOL_SOCKET, SO_KEEPALIVE, &un, sizeof(un));
+    setsockopt(fd, IPPROTO_TCP, TCP_KEEPIDLE, &inactivite, sizeof(inactivite));
+    setsockopt(fd, IPPROTO_TCP, TCP_KEEPINTVL, &intervalle, sizeof(intervalle));
+    setsockopt(fd, IPPROTO_TCP, TCP_KEEPCNT, &sondes, sizeof(sondes));
+    setsockopt(fd, IPPROTO_TCP, TCP_USER_TIMEOUT, &delai_ms, sizeof(delai_ms));
+}
+
+// Ouvre la socket decrite par `adresse`. Leve std::invalid_argument si l'adresse est mal
+// formee ou, pour `ecoute`, si elle ne peut pas etre reservee ; renvoie -1 si la connexion echoue.
+int ouvrir_socket(const std::string& adresse, bool ecoute) {
+    if (adresse.compare(0, 5, "unix:") == 0) {
+        const std::string chemin = adresse.substr(5);
+        sockaddr_un sa{};
+        if (chemin.empty() || chemin.size() >= sizeof(sa.sun_path))
+            throw std::invalid_argument("Chemin de socket Unix invalide : " + adresse);
+        sa.sun_family = AF_UNIX;
+        strncpy(sa.sun_path, chemin.c_str(), sizeof(sa.sun_path) - 1);
+
+        int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd < 0) throw std::invalid_argument("Impossible de creer une socket Unix");
+        if (ecoute) {
+            unlink(chemin.c_str());
+            if (bind(fd, reinterpret_cast<sockaddr*>(&sa), sizeof(sa)) != 0 || listen(fd, 64) != 0) {
+                close(fd);
+                throw std::invalid_argument("Impossible d'ecouter sur " + adresse + " : " + strerror(errno));
+            }
+        }
+        else if (connect(fd, reinterpret_cast<sockaddr*>(&sa), sizeof(sa)) != 0) {
+            close(fd);
+            return -1;
+        }
+        return fd;
+    }
+
+    size_t deux_points = adresse.rfind(':');
+    if (deux_points == std::string::npos || deux_points + 1 == adresse.size())
+        throw std::invalid_argument("Adresse invalide, hote:port ou unix:/chemin attendu : " + adresse);
+    const std::string hote = adresse.substr(0, deux_points), port = adresse.substr(deux_points + 1);
+
+    addrinfo indices{}, *resultats = nullptr;
+    indices.ai_family = AF_UNSPEC;
+    indices.ai_socktype = SOCK_STREAM;
+    indices.ai_flags = ecoute ? AI_PASSIVE : 0;
+    if (getaddrinfo(hote.empty() ? nullptr : hote.c_str(), port.c_str(), &indices, &resultats) != 0)
+        throw std::invalid_argument("Adresse introuvable : " + adresse);
+
+    int fd = -1;
+    for (addrinfo* a = resultats; a != nullptr && fd < 0; a = a->ai_next) {
+        fd = socket(a->ai_family, a->ai_socktype | SOCK_CLOEXEC, a->ai_protocol);
+        if (fd < 0) continue;
+        int un = 1;
+        bool ok;
+        if (ecoute) {
+            setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &un, sizeof(un));
+            ok = bind(fd, a->ai_addr, a->ai_addrlen) == 0 && listen(fd, 64) == 0;
+        }
+        else {
+            ok = connect(fd, a->ai_addr, a->ai_addrlen) == 0;
+            if (ok) {
+                setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &un, sizeof(un));
+                surveiller_connexion(fd);
+            }
+        }
+        if (!ok) {
+            close(fd);
+            fd = -1;
+        }
+    }
+    freeaddrinfo(resultats);
+    if (fd < 0 && ecoute) throw std::invalid_argument("Impossible d'ecouter sur " + adresse + " : " + strerror(errno));
+    return fd;
+}
+
+bool envoyer_octets(int fd, const void* donnees, size_t taille) {
+    const char* p = static_cast<const char*>(donnees);
+    while (taille > 0) {
+        ssize_t n = send(fd, p, taille, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        p += n;
+        taille -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+// Renvoie false si le pair est parti
+bool envoyer_message(int fd, TypeMessage type, const void* debut, size_t taille_debut, const void* suite = nullptr, size_t taille_suite = 0) {
+    EnteteMessage entete{magie_distribue, static_cast<uint32_t>(type), taille_debut + taille_suite};
+    return envoyer_octets(fd, &entete, sizeof(entete)) && envoyer_octets(fd, debut, taille_debut)
+        && (taille_suite == 0 || envoyer_octets(fd, suite, taille_suite));
+}
+
+// Envoi bufferise sur une socket non bloquante : ajouter() met un message en file,
+// ecrire() envoie ce que la socket accepte sans attendre un pair lent
+class EnvoiMessages {
+public:
+    void ajouter(TypeMessage type, const void* debut, size_t taille_debut, const void* suite = nullptr, size_t taille_suite = 0) {
+        EnteteMessage entete{magie_distribue, static_cast<uint32_t>(type), taille_debut + taille_suite};
+        const char* e = reinterpret_cast<const char*>(&entete);
+        octets.insert(octets.end(), e, e + sizeof(entete));
+        octets.insert(octets.end(), static_cast<const char*>(debut), static_cast<const char*>(debut) + taille_debut);
+        if (taille_suite > 0)
+            octets.insert(octets.end(), static_cast<const char*>(suite), static_cast<const char*>(suite) + taille_suite);
+    }
+
+    bool vide() const { return debut == octets.size(); }
+
+    // Renvoie false si le pair est parti ou en cas d'erreur
+    bool ecrire(int fd) {
+        while (debut < octets.size()) {
+            ssize_t n = send(fd, octets.data() + debut, octets.size() - debut, MSG_NOSIGNAL);
+            if (n > 0) {
+                debut += static_cast<size_t>(n);
+                continue;
+            }
+            if (n < 0 && errno == EINTR) continue;
+            return n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK);
+        }
+        octets.clear();
+        debut = 0;
+        return true;
+    }
+
+private:
+    std::vector<char> octets;
+    size_t debut = 0;
+};
+
+// Reception bufferisee sur une socket non bloquante : lire() prend ce qui est arrive,
+// extraire() rend les messages complets un par un
+class ReceptionMessages {
+public:
+    // Renvoie false si le pair a ferme la connexion ou en cas d'erreur
+    bool lire(int fd) {
+        char tampon[1 << 16];
+        while (true) {
+            ssize_t n = recv(fd, tampon, sizeof(tampon), 0);
+            if (n > 0) {
+                octets.insert(octets.end(), tampon, tampon + n);
+                continue;
+            }
+            if (n < 0 && errno == EINTR) continue;
+            return n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK);
+        }
+    }
+
+    // Renvoie 1 si un message complet a ete extrait, 0 s'il manque des octets, -1 si le flux est invalide
+    int extraire(TypeMessage& type, std::vector<char>& contenu) {
+        if (octets.size() - debut < sizeof(EnteteMessage)) return 0;
+        EnteteMessage entete;
+        memcpy(&entete, octets.data() + debut, sizeof(entete));
+        if (entete.magie != magie_distribue || entete.taille > taille_message_max) return -1;
+        if (octets.size() - debut - sizeof(entete) < entete.taille) return 0;
+
+        type = static_cast<TypeMessage>(entete.type);
+        const char* p = octets.data() + debut + sizeof(entete);
+        contenu.assign(p, p + entete.taille);
+        debut += sizeof(entete) + entete.taille;
+        if (debut == octets.size()) {
+            octets.clear();
+            debut = 0;
+        }
+        return 1;
+    }
+
+private:
+    std::vector<char> octets;
+    size_t debut = 0;
+};
+
+// Lecture bloquante d'un message entier ; false si le pair est parti ou si le flux est invalide
+bool recevoir_message(int fd, TypeMessage& type, std::vector<char>& contenu) {
+    auto lire_octets = [fd](void* donnees, size_t taille) {
+        char* p = static_cast<char*>(donnees);
+        while (taille > 0) {
+            ssize_t n = recv(fd, p, taille, 0);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) return false;
+            p += n;
+            taille -= static_cast<size_t>(n);
+        }
+        return true;
+    };
+
+    EnteteMessage entete;
+    if (!lire_octets(&entete, sizeof(entete)) || entete.magie != magie_distribue || entete.taille > taille_message_max)
+        return false;
+    type = static_cast<TypeMessage>(entete.type);
+    contenu.resize(entete.taille);
+    return lire_octets(contenu.data(), contenu.size());
+}
+
+// Rend l'image de `moteur` avec les noeuds qui se connectent a options.adresse, puis la resout.
+// Renvoie false si plus aucun noeud n'est connecte pendant options.attente_noeuds secondes
+// alors qu'il reste des regions. Leve std::invalid_argument si l'adresse n'est pas utilisable.
+bool coordonner_rendu(MoteurRendu& moteur, const OptionsDistribue& options, std::ostream& journal) {
+    PorteeTrace trace("rendu distribue");
+    using horloge = std::chrono::steady_clock;
+
+    const int ecoute = ouvrir_socket(options.adresse, true);
+    fcntl(ecoute, F_SETFL, O_NONBLOCK);
+
+    const std::string xml = moteur.documentXml();
+    const MessageScene drapeaux{moteur.obtenirCollecteAOV(), moteur.obtenirCollecteCout()};
+    const std::vector<Tuile> regions = decouper_en_tuiles(moteur.obtenirLargeurImage(), moteur.obtenirHauteurImage(),
+                                                          std::max(1, options.taille_region));
+    moteur.commencerRegions(false);
+
+    struct EtatRegion {
+        bool terminee = false;
+        int copies = 0;             // noeuds qui l'ont en charge
+        horloge::time_point debut;  // confiee au premier d'entre eux
+    };
+    struct Noeud {
+        int fd;
+        int identifiant;
+        ReceptionMessages reception;
+        EnvoiMessages envoi;        // la scene puis les regions, au rythme ou le noeud les lit
+        std::vector<int> regions;
+        int rendues = 0;
+        bool perdu = false;
+    };
+    std::vector<EtatRegion> etats(regions.size());
+    std::deque<int> en_attente;
+    for (int r = 0; r < static_cast<int>(regions.size()); r++) en_attente.push_back(r);
+    std::vector<Noeud> noeuds;
+    int restantes = static_cast<int>(regions.size()), prochain_identifiant = 0;
+    int reprises = 0, doublees = 0;
+    double duree_totale = 0;
+    horloge::time_point dernier_noeud = horloge::now();
+    const size_t canaux = static_cast<size_t>(moteur.canauxRegion());
+
+    auto affecter = [&](Noeud& n, int r) {
+        const Tuile& t = regions[r];
+        MessageRegion m{r, t.x0, t.y0, t.x1, t.y1};
+        // Comptee des la mise en file : si l'envoi echoue, la region repart avec celles du noeud perdu
+        if (etats[r].copies++ == 0) etats[r].debut = horloge::now();
+        n.regions.push_back(r);
+        n.envoi.ajouter(TypeMessage::Region, &m, sizeof(m));
+    };
+
+    // Region la plus en retard que ce noeud n'a pas deja, si elle depasse le seuil de lenteur
+    auto region_a_doubler = [&](const Noeud& n) {
+        const int terminees = static_cast<int>(regions.size()) - restantes;
+        if (terminees == 0) return -1;
+        const double seuil = options.facteur_lenteur * duree_totale / terminees;
+        int choix = -1;
+        double retard_max = seuil;
+        for (int r = 0; r < static_cast<int>(regions.size()); r++) {
+            if (etats[r].terminee || etats[r].copies != 1 || std::count(n.regions.begin(), n.regions.end(), r) > 0) continue;
+            double retard = std::chrono::duration<double>(horloge::now() - etats[r].debut).count();
+            if (retard > retard_max) {
+                retard_max = retard;
+                choix = r;
+            }
+        }
+        return choix;
+    };
+
+    auto recevoir_resultat = [&](Noeud& n, const std::vector<char>& contenu) {
+        MessageRegion m;
+        if (contenu.size() < sizeof(m)) return false;
+        memcpy(&m, contenu.data(), sizeof(m));
+        auto it = std::find(n.regions.begin(), n.regions.end(), m.numero);
+        if (it == n.regions.end()) return false;
+        n.regions.erase(it);
+        etats[m.numero].copies--;
+        if (etats[m.numero].terminee) return true;  // doublon arrive second
+
+        const Tuile& t = regions[m.numero];
+        std::vector<float> donnees((contenu.size() - sizeof(m)) / sizeof(float));
+        memcpy(donnees.data(), contenu.data() + sizeof(m), donnees.size() * sizeof(float));
+        if (donnees.size() != canaux * (t.x1 - t.x0) * (t.y1 - t.y0) || !moteur.integrerRegion(t, donnees))
+            return false;
+        etats[m.numero].terminee = true;
+        duree_totale += std::chrono::duration<double>(horloge::now() - etats[m.numero].debut).count();
+        restantes--;
+        n.rendues++;
+        return true;
+    };
+
+    while (restantes > 0) {
+        // Chaque noeud garde des regions d'avance pour ne jamais attendre le coordinateur
+        for (Noeud& n : noeuds) {
+            while (!n.perdu && static_cast<int>(n.regions.size()) <= options.regions_d_avance) {
+                int r = -1;
+                while (!en_attente.empty() && r < 0) {
+                    r = en_attente.front();
+                    en_attente.pop_front();
+                    if (etats[r].terminee) r = -1;
+                }
+                if (r < 0 && (r = region_a_doubler(n)) >= 0) doublees++;
+                if (r < 0) break;
+                affecter(n, r);
+            }
+            if (!n.perdu && !n.envoi.ecrire(n.fd)) n.perdu = true;
+        }
+
+        // Les regions des noeuds perdus repartent en tete de file
+        for (Noeud& n : noeuds) {
+            if (!n.perdu) continue;
+            journal << "Noeud " << n.identifiant << " perdu, " << n.regions.size() << " region(s) reprise(s)" << std::endl;
+            for (int r : n.regions) {
+                if (--etats[r].copies == 0 && !etats[r].terminee) {
+                    en_attente.push_front(r);
+                    reprises++;
+                }
+            }
+            close(n.fd);
+        }
+        noeuds.erase(std::remove_if(noeuds.begin(), noeuds.end(), [](const Noeud& n) { return n.perdu; }), noeuds.end());
+        if (!noeuds.empty()) dernier_noeud = horloge::now();
+        else if (std::chrono::duration<double>(horloge::now() - dernier_noeud).count() > options.attente_noeuds) {
+            journal << "Aucun noeud de calcul depuis " << options.attente_noeuds << " s, " << restantes << " region(s) non rendue(s)" << std::endl;
+            break;
+        }
+
+        std::vector<pollfd> attente(1, pollfd{ecoute, POLLIN, 0});
+        for (const Noeud& n : noeuds)
+            attente.push_back(pollfd{n.fd, static_cast<short>(n.envoi.vide() ? POLLIN : POLLIN | POLLOUT), 0});
+        if (poll(attente.data(), attente.size(), 100) < 0 && errno != EINTR) break;
+
+        for (size_t k = 1; k < attente.size(); k++) {
+            Noeud& n = noeuds[k - 1];
+            if (attente[k].revents == 0) continue;
+            if ((attente[k].revents & POLLOUT) && !n.envoi.ecrire(n.fd)) n.perdu = true;
+            bool ouvert = n.reception.lire(n.fd);
+            TypeMessage type;
+            std::vector<char> contenu;
+            int etat;
+            while ((etat = n.reception.extraire(type, contenu)) > 0) {
+                if (type != TypeMessage::Resultat || !recevoir_resultat(n, contenu)) {
+                    etat = -1;
+                    break;
+                }
+            }
+            if (etat < 0) journal << "Noeud " << n.identifiant << " : message invalide" << std::endl;
+            n.perdu = n.perdu || !ouvert || etat < 0;
+        }
+
+        if (attente[0].revents & POLLIN) {
+            int fd;
+            // La scene part par la file d'envoi : un noeud qui ne la lit pas ne bloque pas les autres
+            while ((fd = accept4(ecoute, nullptr, nullptr, SOCK_CLOEXEC | SOCK_NONBLOCK)) >= 0) {
+                int un = 1;
+                setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &un, sizeof(un));
+                surveiller_connexion(fd);
+                Noeud& n = noeuds.emplace_back();
+                n.fd = fd;
+                n.identifiant = prochain_identifiant++;
+                n.envoi.ajouter(TypeMessage::Scene, &drapeaux, sizeof(drapeaux), xml.data(), xml.size());
+                journal << "Noeud " << n.identifiant << " connecte" << std::endl;
+            }
+        }
+    }
+
+    for (Noeud& n : noeuds) {
+        n.envoi.ajouter(TypeMessage::Fin, nullptr, 0);
+        n.envoi.ecrire(n.fd);
+        journal << "Noeud " << n.identifiant << " : " << n.rendues << " region(s)" << std::endl;
+        close(n.fd);
+    }
+    close(ecoute);
+    if (options.adresse.compare(0, 5, "unix:") == 0) unlink(options.adresse.c_str() + 5);
+
+    journal << regions.size() - restantes << "/" << regions.size() << " regions, " << reprises << " reprise(s), "
+            << doublees << " doublee(s)" << std::endl;
+    if (restantes > 0) return false;
+    moteur.terminerRegions();
+    return true;
+}
+
+// Noeud de calcul : rejoint le coordinateur, recoit la scene puis rend les regions demandees
+// jusqu'au message de fin. Codes : 0 fin normale, 1 coordinateur injoignable ou scene invalide,
+// 3 coordinateur perdu en cours de rendu.
+int executer_noeud(const OptionsDistribue& options, std::ostream& journal) {
+    int fd = -1;
+    const auto limite = std::chrono::steady_clock::now() + std::chrono::duration<double>(options.attente_connexion);
+    try {
+        // Le coordinateur peut demarrer apres les noeuds
+        while ((fd = ouvrir_socket(options.adresse, false)) < 0 && std::chrono::steady_clock::now() < limite)
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+    catch (std::exception& e) {
+        journal << e.what() << std::endl;
+        return 1;
+    }
+    if (fd < 0) {
+        journal << "Impossible de joindre le coordinateur " << options.adresse << std::endl;
+        return 1;
+    }
+
+    TypeMessage type;
+    std::vector<char> contenu;
+    MessageScene drapeaux;
+    if (!recevoir_message(fd, type, contenu) || type != TypeMessage::Scene || contenu.size() < sizeof(drapeaux)) {
+        journal << "Le coordinateur n'a pas envoye de scene" << std::endl;
+        close(fd);
+        return 1;
+    }
+    memcpy(&drapeaux, contenu.data(), sizeof(drapeaux));
+
+    MoteurRendu moteur(1, 1);
+    try {
+        PorteeTrace trace("chargement scene");
+        moteur = MoteurRendu::depuisDocumentXml(std::string(contenu.begin() + sizeof(drapeaux), contenu.end()));
+    }
+    catch (std::exception& e) {
+        journal << "Scene recue invalide : " << e.what() << std::endl;
+        close(fd);
+        return 1;
+    }
+    if (options.threads > 0) moteur.definirNombreThreads(options.threads);
+    moteur.definirCollecteAOV(drapeaux.collecte_aov != 0);
+    moteur.definirCollecteCout(drapeaux.collecte_cout != 0);
+    moteur.commencerRegions(true);
+
+    int code = 3;
+    while (recevoir_message(fd, type, contenu)) {
+        if (type == TypeMessage::Fin) {
+            code = 0;
+            break;
+        }
+        MessageRegion m;
+        if (type != TypeMessage::Region || contenu.size() != sizeof(m)) break;
+        memcpy(&m, contenu.data(), sizeof(m));
+        const Tuile zone{m.x0, m.y0, m.x1, m.y1};
+        if (!moteur.regionValide(zone)) break;
+
+        moteur.rendreRegion(zone);
+        const std::vector<float> donnees = moteur.extraireRegion(zone);
+        if (!envoyer_message(fd, TypeMessage::Resultat, &m, sizeof(m), donnees.data(), donnees.size() * sizeof(float)))
+            break;
+    }
+    if (code != 0) journal << "Connexion au coordinateur perdue" << std::endl;
+    close(fd);
+    return code;
+}
+
+#endif // RENDUDISTRIBUE_H_INCLUDED
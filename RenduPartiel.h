@@ -0,0 +1,186 @@
+#ifndef RENDUPARTIEL_H_INCLUDED
+#define RENDUPARTIEL_H_INCLUDED
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "MoteurDeRendu.h"
+#include "ImageHDR.h"
+
+#include "../include/tinyxml2.h"
+
+// Rendu partiel (.rtpart) : sommes des echantillons et nombre d'echantillons de chaque pixel,
+// avec les parametres du moteur en XML. Des rendus de la meme scene faits separement, avec des
+// graines differentes, s'additionnent : la moyenne fusionnee pondere chaque rendu par son
+// nombre d'echantillons. Une fusion garde la liste des graines de ses rendus, pour refuser
+// plus tard un rendu qui en repeterait une. Les flottants par pixel suivent
+// MoteurRendu::extraireRegion (radiance, echantillons, puis AOV et cout s'ils ont ete collectes),
+// dans l'ordre de la machine.
+
+namespace rendu_partiel {
+    const char magique[8] = {'R', 'T', 'P', 'A', 'R', 'T', '\0', '\0'};
+    const uint32_t version = 3;
+    const uint64_t graines_max = uint64_t(1) << 20;
+    const uint32_t controle_boutisme = 0x01020304;
+
+    enum Drapeaux : uint32_t { AOV = 1, Cout = 2 };
+}
+
+struct EnteteRenduPartiel {
+    char magique[8];
+    uint32_t version;
+    uint32_t boutisme;
+    int32_t largeur, hauteur;
+    uint32_t canaux;             // flottants par pixel
+    uint32_t drapeaux;           // rendu_partiel::Drapeaux
+    uint64_t nombre_graines;     // graines (uint64_t) qui suivent l'entete
+    uint64_t empreinte;          // MoteurRendu::empreinteScene
+    uint64_t taille_parametres;  // octets du XML qui suit les graines ; les pixels viennent ensuite
+};
+
+struct RenduPartiel {
+    std::string parametres;  // element <MoteurRendu>
+    int largeur = 0, hauteur = 0, canaux = 0;
+    uint32_t drapeaux = 0;
+    std::vector<uint64_t> graines;  // une par rendu additionne
+    uint64_t empreinte = 0;
+    std::vector<float> donnees;
+
+    size_t nombre_flottants() const { return static_cast<size_t>(largeur) * hauteur * canaux; }
+};
+
+inline bool est_rendu_partiel(const std::string& nom) {
+    return finit_par(nom, ".rtpart");
+}
+
+// Le fichier est ecrit a cote puis renomme : un noeud interrompu ne laisse pas de fichier tronque
+bool ecrire_rendu_partiel(const std::string& nom, const RenduPartiel& partiel) {
+    EnteteRenduPartiel e{};
+    memcpy(e.magique, rendu_partiel::magique, sizeof(e.magique));
+    e.version = rendu_partiel::version;
+    e.boutisme = rendu_partiel::controle_boutisme;
+    e.largeur = partiel.largeur;
+    e.hauteur = partiel.hauteur;
+    e.canaux = static_cast<uint32_t>(partiel.canaux);
+    e.drapeaux = partiel.drapeaux;
+    e.nombre_graines = partiel.graines.size();
+    e.empreinte = partiel.empreinte;
+    e.taille_parametres = partiel.parametres.size();
+
+    const std::string temporaire = nom + ".tmp";
+    {
+        std::ofstream f(temporaire, std::ios::binary);
+        if (!f) return false;
+        f.write(reinterpret_cast<const char*>(&e), sizeof(e));
+        f.write(reinterpret_cast<const char*>(partiel.graines.data()), partiel.graines.size() * sizeof(uint64_t));
+        f.write(partiel.parametres.data(), partiel.parametres.size());
+        f.write(reinterpret_cast<const char*>(partiel.donnees.data()), partiel.donnees.size() * sizeof(float));
+        if (!f) return false;
+    }
+    return rename(temporaire.c_str(), nom.c_str()) == 0;
+}
+
+// Leve std::invalid_argument si le fichier est illisible, tronque ou d'une autre version
+RenduPartiel lire_rendu_partiel(const std::string& nom) {
+    std::ifstream f(nom, std::ios::binary);
+    if (!f) throw std::invalid_argument("Impossible d'ouvrir le rendu partiel " + nom);
+
+    EnteteRenduPartiel e;
+    if (!f.read(reinterpret_cast<char*>(&e), sizeof(e)) || memcmp(e.magique, rendu_partiel::magique, sizeof(e.magique)) != 0)
+        throw std::invalid_argument(nom + " n'est pas un rendu partiel");
+    if (e.version != rendu_partiel::version || e.boutisme != rendu_partiel::controle_boutisme)
+        throw std::invalid_argument("Version ou boutisme du rendu partiel non pris en charge : " + nom);
+    if (e.largeur <= 0 || e.hauteur <= 0 || e.canaux < 4 || e.taille_parametres > (uint64_t(1) << 24)
+        || e.nombre_graines == 0 || e.nombre_graines > rendu_partiel::graines_max)
+        throw std::invalid_argument("Rendu partiel corrompu : " + nom);
+
+    RenduPartiel partiel;
+    partiel.largeur = e.largeur;
+    partiel.hauteur = e.hauteur;
+    partiel.canaux = static_cast<int>(e.canaux);
+    partiel.drapeaux = e.drapeaux;
+    partiel.empreinte = e.empreinte;
+    partiel.graines.resize(e.nombre_graines);
+    partiel.parametres.resize(e.taille_parametres);
+    partiel.donnees.resize(partiel.nombre_flottants());
+    f.read(reinterpret_cast<char*>(partiel.graines.data()), partiel.graines.size() * sizeof(uint64_t));
+    f.read(&partiel.parametres[0], partiel.parametres.size());
+    f.read(reinterpret_cast<char*>(partiel.donnees.data()), partiel.donnees.size() * sizeof(float));
+    if (!f || f.peek() != std::char_traits<char>::eof())
+        throw std::invalid_argument("Rendu partiel tronque : " + nom);
+    return partiel;
+}
+
+// Ajoute les echantillons de `autre` a `somme`. Leve std::invalid_argument si les deux rendus
+// ne sont pas ceux de la meme scene, n'ont pas la meme taille ou pas les memes canaux, ou ont
+// une graine en commun : ils auraient alors les memes echantillons et la variance ne baisserait pas.
+void ajouter_rendu_partiel(RenduPartiel& somme, const RenduPartiel& autre) {
+    if (somme.empreinte != autre.empreinte)
+        throw std::invalid_argument("Les rendus partiels ne sont pas ceux de la meme scene avec les memes reglages");
+    if (somme.largeur != autre.largeur || somme.hauteur != autre.hauteur || somme.canaux != autre.canaux
+        || somme.drapeaux != autre.drapeaux)
+        throw std::invalid_argument("Les rendus partiels n'ont pas la meme taille ou les memes canaux");
+    for (uint64_t graine : autre.graines) {
+        if (std::find(somme.graines.begin(), somme.graines.end(), graine) != somme.graines.end())
+            throw std::invalid_argument("Les rendus partiels ont une graine en commun (" + std::to_string(graine) + ")");
+    }
+    if (somme.graines.size() + autre.graines.size() > rendu_partiel::graines_max)
+        throw std::invalid_argument("Trop de rendus partiels fusionnes");
+    somme.graines.insert(somme.graines.end(), autre.graines.begin(), autre.graines.end());
+    for (size_t i = 0; i < somme.donnees.size(); i++)
+        somme.donnees[i] += autre.donnees[i];
+}
+
+// Rendu partiel de l'image terminee de `moteur`
+RenduPartiel extraire_rendu_partiel(const MoteurRendu& moteur) {
+    tinyxml2::XMLDocument xmlDoc;
+    xmlDoc.InsertFirstChild(moteur.parametresXml(xmlDoc));
+    tinyxml2::XMLPrinter printer;
+    xmlDoc.Print(&printer);
+
+    RenduPartiel partiel;
+    partiel.parametres = printer.CStr();
+    partiel.largeur = moteur.obtenirLargeurImage();
+    partiel.hauteur = moteur.obtenirHauteurImage();
+    partiel.canaux = moteur.canauxRegion();
+    // Memes conditions que la collecte du moteur
+    partiel.drapeaux = (moteur.obtenirCollecteAOV() || moteur.obtenirDebruitage().actif ? rendu_partiel::AOV : 0)
+                     | (moteur.obtenirCollecteCout() ? rendu_partiel::Cout : 0);
+    partiel.graines.push_back(moteur.obtenirGraine());
+    partiel.empreinte = moteur.empreinteScene();
+    partiel.donnees = moteur.extraireRegion(Tuile{0, 0, partiel.largeur, partiel.hauteur});
+    return partiel;
+}
+
+// Moteur sans scene dont l'image est celle du rendu partiel, resolue avec ses parametres
+// (debruitage compris s'il est actif et que les AOV sont la). Leve std::invalid_argument
+// si les parametres ne correspondent pas aux pixels.
+void charger_rendu_partiel(MoteurRendu& moteur, const RenduPartiel& partiel) {
+    tinyxml2::XMLDocument xmlDoc;
+    if (xmlDoc.Parse(partiel.parametres.data(), partiel.parametres.size()) != tinyxml2::XML_SUCCESS
+        || xmlDoc.FirstChildElement("MoteurRendu") == nullptr)
+        throw std::invalid_argument("Le rendu partiel ne contient pas d'élément moteur de rendu");
+    moteur.lireParametres(xmlDoc.FirstChildElement("MoteurRendu"));
+
+    // Sans AOV, le debruitage est impossible : les canaux doivent correspondre a ceux du fichier
+    if (!(partiel.drapeaux & rendu_partiel::AOV)) {
+        ParametresDebruitage debruitage = moteur.obtenirDebruitage();
+        debruitage.actif = false;
+        moteur.definirDebruitage(debruitage);
+    }
+    moteur.definirCollecteAOV((partiel.drapeaux & rendu_partiel::AOV) != 0);
+    moteur.definirCollecteCout((partiel.drapeaux & rendu_partiel::Cout) != 0);
+
+    moteur.commencerRegions(false);
+    if (!moteur.integrerRegion(Tuile{0, 0, partiel.largeur, partiel.hauteur}, partiel.donnees))
+        throw std::invalid_argument("Les pixels du rendu partiel ne correspondent pas a ses parametres");
+    moteur.terminerRegions();
+}
+
+#endif // RENDUPARTIEL_H_INCLUDED
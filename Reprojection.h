@@ -0,0 +1,281 @@
+#ifndef REPROJECTION_H_INCLUDED
+#define REPROJECTION_H_INCLUDED
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "camera.h"
+
+#include "../include/tinyxml2.h"
+
+// Reglages de l'accumulation temporelle : l'image precedente, reprojetee sur la courante,
+// compte comme des echantillons de plus la ou elle montre la meme surface. Ces pixels ne
+// recoivent alors que les echantillons neufs qui manquent a leur historique.
+// Pres d'un objet mobile, l'eclairage change d'une image a l'autre (ombres, bords flous) plus
+// vite que le voisinage de quelques echantillons ne permet de le voir : l'historique y pese peu.
+struct ParametresTemporel {
+    bool actif = false;
+    int echantillons = 4;          // echantillons neufs minimum d'un pixel dont l'historique est repris
+    float historique_max = 32;     // poids maximal de l'historique, en echantillons
+    float historique_mobile = 4;   // poids maximal a moins de rayon_mobile pixels d'un objet mobile
+    int rayon_mobile = 3;
+    float seuil_normale = 0.9f;    // cosinus minimal entre les normales
+    float seuil_distance = 0.02f;  // ecart de position, relatif a la distance a la camera
+    float ecart_couleur = 1.0f;    // l'historique est ramene a moyenne +- ecart * ecart-type du voisinage neuf (YCoCg)
+
+    ParametresTemporel() {}
+
+    ParametresTemporel(tinyxml2::XMLElement* pElement) {
+        actif = pElement->BoolAttribute("Actif", actif);
+        echantillons = pElement->IntAttribute("Echantillons", echantillons);
+        historique_max = pElement->FloatAttribute("HistoriqueMax", historique_max);
+        historique_mobile = pElement->FloatAttribute("HistoriqueMobile", historique_mobile);
+        rayon_mobile = pElement->IntAttribute("RayonMobile", rayon_mobile);
+        seuil_normale = pElement->FloatAttribute("SeuilNormale", seuil_normale);
+        seuil_distance = pElement->FloatAttribute("SeuilDistance", seuil_distance);
+        ecart_couleur = pElement->FloatAttribute("EcartCouleur", ecart_couleur);
+    }
+
+    tinyxml2::XMLElement* to_xml(tinyxml2::XMLDocument& xmlDoc) const {
+        tinyxml2::XMLElement * pElement = xmlDoc.NewElement("Temporel");
+        pElement->SetAttribute("Actif", actif);
+        pElement->SetAttribute("Echantillons", echantillons);
+        pElement->SetAttribute("HistoriqueMax", historique_max);
+        pElement->SetAttribute("HistoriqueMobile", historique_mobile);
+        pElement->SetAttribute("RayonMobile", rayon_mobile);
+        pElement->SetAttribute("SeuilNormale", seuil_normale);
+        pElement->SetAttribute("SeuilDistance", seuil_distance);
+        pElement->SetAttribute("EcartCouleur", ecart_couleur);
+        return pElement;
+    }
+};
+
+const uint32_t sans_primitive = UINT32_MAX;
+
+// Premier impact du rayon sans ouverture passant par le centre d'un pixel, au milieu de l'obturation
+struct GuidePixel {
+    float position[3];   // point touche ; direction du rayon pour le ciel
+    float normale[3];
+    float vitesse[3];    // du point touche, nulle pour le ciel
+    float distance;      // de la camera au point touche
+    uint32_t primitive;  // sans_primitive pour le ciel
+};
+
+// Image resolue precedente et ses guides
+class HistoriqueTemporel {
+public:
+    bool vide() const { return radiance.empty(); }
+
+    void vider() {
+        radiance.clear();
+        poids.clear();
+        guides.clear();
+    }
+
+    // Reprojette l'historique sur les guides de l'image courante. `rep_radiance` (RVB) et
+    // `rep_poids` ont une valeur par pixel ; le poids est nul la ou la surface n'etait pas visible.
+    // Les vecteurs restent vides s'il n'y a pas d'historique de la meme taille.
+    void reprojeter(const std::vector<GuidePixel>& guides_courants, double temps_courant, int largeur, int hauteur,
+                    const ParametresTemporel& parametres, std::vector<float>& rep_radiance, std::vector<float>& rep_poids) const;
+
+    // Un pixel plus lumineux que tous ses voisins (luciole) est ramene a leur maximum : sans cela
+    // il resterait dans l'historique pendant des images. L'image affichee n'est pas modifiee.
+    void memoriser(std::vector<float> radiance_resolue, std::vector<float> poids_resolus, std::vector<GuidePixel> guides_courants,
+                   const camera& cam_courante, double temps_courant, int largeur_img, int hauteur_img) {
+        radiance = std::move(radiance_resolue);
+        eteindre_lucioles(largeur_img, hauteur_img);
+        poids = std::move(poids_resolus);
+        guides = std::move(guides_courants);
+        cam = cam_courante;
+        temps = temps_courant;
+        largeur = largeur_img;
+        hauteur = hauteur_img;
+    }
+
+private:
+    void eteindre_lucioles(int largeur_img, int hauteur_img);
+
+    // Le texel precedent `k` montre-t-il la surface du guide courant, deplacee en `p` ?
+    bool compatible(const GuidePixel& courant, const vecteur3& p, int k, const ParametresTemporel& parametres) const;
+
+    std::vector<float> radiance, poids;
+    std::vector<GuidePixel> guides;
+    camera cam;
+    double temps = 0;
+    int largeur = 0, hauteur = 0;
+};
+
+void HistoriqueTemporel::eteindre_lucioles(int largeur_img, int hauteur_img) {
+    std::vector<float> lum(static_cast<size_t>(largeur_img) * hauteur_img);
+    for (size_t k = 0; k < lum.size(); k++)
+        lum[k] = 0.2126f * radiance[3*k] + 0.7152f * radiance[3*k + 1] + 0.0722f * radiance[3*k + 2];
+
+    for (int lig = 0; lig < hauteur_img; lig++) {
+        for (int i = 0; i < largeur_img; i++) {
+            const int indice = lig * largeur_img + i;
+            float voisins = 0;
+            for (int l = std::max(0, lig - 1); l <= std::min(hauteur_img - 1, lig + 1); l++)
+                for (int k = std::max(0, i - 1); k <= std::min(largeur_img - 1, i + 1); k++)
+                    if (l != lig || k != i) voisins = std::max(voisins, lum[l * largeur_img + k]);
+            if (lum[indice] <= voisins) continue;
+            const float facteur = voisins / lum[indice];
+            for (int c = 0; c < 3; c++) radiance[3*indice + c] *= facteur;
+        }
+    }
+}
+
+bool HistoriqueTemporel::compatible(const GuidePixel& courant, const vecteur3& p, int k, const ParametresTemporel& parametres) const {
+    const GuidePixel& g = guides[k];
+    if (poids[k] <= 0 || g.primitive != courant.primitive) return false;
+    if (courant.primitive == sans_primitive) return true;
+
+    double cos_normales = 0, ecart2 = 0;
+    for (int c = 0; c < 3; c++) {
+        cos_normales += g.normale[c] * courant.normale[c];
+        ecart2 += (g.position[c] - p[c]) * (g.position[c] - p[c]);
+    }
+    double tolerance = parametres.seuil_distance * courant.distance;
+    return cos_normales >= parametres.seuil_normale && ecart2 <= tolerance * tolerance;
+}
+
+void HistoriqueTemporel::reprojeter(const std::vector<GuidePixel>& guides_courants, double temps_courant, int largeur_img,
+                                    int hauteur_img, const ParametresTemporel& parametres,
+                                    std::vector<float>& rep_radiance, std::vector<float>& rep_poids) const {
+    rep_radiance.clear();
+    rep_poids.clear();
+    if (vide() || largeur != largeur_img || hauteur != hauteur_img) return;
+
+    rep_radiance.assign(3 * static_cast<size_t>(largeur) * hauteur, 0.0f);
+    rep_poids.assign(static_cast<size_t>(largeur) * hauteur, 0.0f);
+    const double dt = temps_courant - temps;
+
+    for (int indice = 0; indice < largeur * hauteur; indice++) {
+        const GuidePixel& g = guides_courants[indice];
+
+        // Position du point a l'image precedente ; le ciel ne depend que de la direction
+        vecteur3 p(g.position[0] - dt * g.vitesse[0], g.position[1] - dt * g.vitesse[1], g.position[2] - dt * g.vitesse[2]);
+        double s, t;
+        if (!cam.project(g.primitive == sans_primitive ? cam.getPosition() + p : p, s, t)) continue;
+
+        // Coordonnees dans l'image precedente, centres des pixels aux valeurs entieres
+        const double x = s * (largeur - 1) - 0.5;
+        const double y = (hauteur - 1) - (t * (hauteur - 1) - 0.5);
+        const int x0 = static_cast<int>(std::floor(x)), y0 = static_cast<int>(std::floor(y));
+        const double fx = x - x0, fy = y - y0;
+
+        // Interpolation bilineaire sur les texels qui montrent la meme surface
+        double somme_poids = 0, historique = 0, rvb[3] = {0, 0, 0};
+        for (int dy = 0; dy <= 1; dy++) {
+            for (int dx = 0; dx <= 1; dx++) {
+                const int xi = x0 + dx, yi = y0 + dy;
+                if (xi < 0 || xi >= largeur || yi < 0 || yi >= hauteur) continue;
+                const int k = yi * largeur + xi;
+                if (!compatible(g, p, k, parametres)) continue;
+                const double w = (dx ? fx : 1 - fx) * (dy ? fy : 1 - fy);
+                somme_poids += w;
+                historique += w * poids[k];
+                for (int c = 0; c < 3; c++) rvb[c] += w * radiance[3*k + c];
+            }
+        }
+        if (somme_poids < 1e-3) continue;
+
+        for (int c = 0; c < 3; c++) rep_radiance[3*indice + c] = static_cast<float>(rvb[c] / somme_poids);
+        rep_poids[indice] = static_cast<float>(historique / somme_poids);
+    }
+
+    // Pixels a moins de rayon_mobile d'un objet mobile, dans l'image courante ou la precedente :
+    // dilatation horizontale puis verticale
+    const int n = largeur * hauteur, rayon = std::max(0, parametres.rayon_mobile);
+    auto mobile = [](const GuidePixel& g) { return g.vitesse[0] != 0 || g.vitesse[1] != 0 || g.vitesse[2] != 0; };
+    std::vector<char> proche(n), ligne(n);
+    bool aucun = true;
+    for (int k = 0; k < n; k++) {
+        proche[k] = mobile(guides_courants[k]) || mobile(guides[k]);
+        aucun = aucun && !proche[k];
+    }
+    if (aucun) return;
+    for (int y = 0; y < hauteur; y++)
+        for (int x = 0; x < largeur; x++)
+            for (int k = std::max(0, x - rayon); k <= std::min(largeur - 1, x + rayon) && !ligne[y * largeur + x]; k++)
+                ligne[y * largeur + x] = proche[y * largeur + k];
+    for (int y = 0; y < hauteur; y++) {
+        for (int x = 0; x < largeur; x++) {
+            bool pres = false;
+            for (int l = std::max(0, y - rayon); l <= std::min(hauteur - 1, y + rayon) && !pres; l++)
+                pres = ligne[l * largeur + x];
+            if (pres) rep_poids[y * largeur + x] = std::min(rep_poids[y * largeur + x], parametres.historique_mobile);
+        }
+    }
+}
+
+inline void rvb_vers_ycocg(const float* rvb, double* ycocg) {
+    ycocg[0] = 0.25 * rvb[0] + 0.5 * rvb[1] + 0.25 * rvb[2];
+    ycocg[1] = 0.5 * rvb[0] - 0.5 * rvb[2];
+    ycocg[2] = -0.25 * rvb[0] + 0.5 * rvb[1] - 0.25 * rvb[2];
+}
+
+inline void ycocg_vers_rvb(const double* ycocg, float* rvb) {
+    const double t = ycocg[0] - ycocg[2];
+    rvb[0] = static_cast<float>(t + ycocg[1]);
+    rvb[1] = static_cast<float>(ycocg[0] + ycocg[2]);
+    rvb[2] = static_cast<float>(t - ycocg[1]);
+}
+
+// Moyenne des echantillons neufs (sommes `accumulation`, nombres `echantillons`) et de l'historique
+// reprojete. L'historique est d'abord ramene dans la boite des echantillons neufs du voisinage 3x3,
+// en YCoCg ou la luminance et la teinte varient separement : un reflet ou une ombre qui bouge sur
+// une surface immobile ne laisse pas de trainee.
+void melanger_historique(const std::vector<float>& accumulation, const std::vector<uint32_t>& echantillons,
+                         const std::vector<float>& rep_radiance, const std::vector<float>& rep_poids, int largeur, int hauteur,
+                         const ParametresTemporel& parametres, std::vector<float>& radiance, std::vector<float>& poids) {
+    const size_t n = echantillons.size();
+    std::vector<float> neuf(3 * n, 0.0f);
+    for (size_t indice = 0; indice < n; indice++)
+        for (int c = 0; c < 3 && echantillons[indice] > 0; c++)
+            neuf[3*indice + c] = accumulation[3*indice + c] / echantillons[indice];
+
+    radiance.assign(3 * n, 0.0f);
+    poids.assign(n, 0.0f);
+    for (int lig = 0; lig < hauteur; lig++) {
+        for (int i = 0; i < largeur; i++) {
+            const int indice = lig * largeur + i;
+            float w = rep_poids.empty() ? 0.0f : std::min(rep_poids[indice], parametres.historique_max);
+            const float total = echantillons[indice] + w;
+            if (total <= 0) continue;
+
+            float historique[3] = {0, 0, 0};
+            if (w > 0) {
+                double somme[3] = {0, 0, 0}, carres[3] = {0, 0, 0};
+                int voisins = 0;
+                for (int l = std::max(0, lig - 1); l <= std::min(hauteur - 1, lig + 1); l++) {
+                    for (int k = std::max(0, i - 1); k <= std::min(largeur - 1, i + 1); k++) {
+                        if (echantillons[l * largeur + k] == 0) continue;
+                        double v[3];
+                        rvb_vers_ycocg(&neuf[3 * (l * largeur + k)], v);
+                        for (int c = 0; c < 3; c++) {
+                            somme[c] += v[c];
+                            carres[c] += v[c] * v[c];
+                        }
+                        voisins++;
+                    }
+                }
+                double h[3];
+                rvb_vers_ycocg(&rep_radiance[3*indice], h);
+                for (int c = 0; c < 3 && voisins > 0; c++) {
+                    double moyenne = somme[c] / voisins;
+                    double ecart = parametres.ecart_couleur * std::sqrt(std::max(0.0, carres[c] / voisins - moyenne * moyenne));
+                    h[c] = std::clamp(h[c], moyenne - ecart, moyenne + ecart);
+                }
+                ycocg_vers_rvb(h, historique);
+            }
+
+            for (int c = 0; c < 3; c++)
+                radiance[3*indice + c] = (accumulation[3*indice + c] + historique[c] * w) / total;
+            poids[indice] = total;
+        }
+    }
+}
+
+#endif // REPROJECTION_H_INCLUDED
@@ -0,0 +1,291 @@
+#ifndef SCENEBINAIRE_H_INCLUDED
+#define SCENEBINAIRE_H_INCLUDED
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "ObjectList.h"
+#include "BVH.h"
+#include "SoupeSpheres.h"
+#include "ImageHDR.h"
+#include "materiau.h"
+
+// Scene binaire (.rtsb) : parametres du moteur en XML, puis tableaux a plat (materiaux,
+// spheres de la soupe dans l'ordre des feuilles, noeuds du BVH et, si des spheres bougent,
+// leurs boites a la fin de l'obturation). Le fichier est projete
+// en memoire et les tableaux sont utilises en place, sans allocation par objet.
+// Chaque section commence sur une ligne de cache ; les entiers sont dans l'ordre de la machine.
+
+namespace scene_binaire {
+    const char magique[8] = {'R', 'T', 'S', 'C', 'E', 'N', 'E', '\0'};
+    const uint32_t version = 2;
+    const uint32_t controle_boutisme = 0x01020304;
+    const uint64_t alignement = 64;
+
+    enum Section {
+        Parametres, Materiaux,
+        CentresX, CentresY, CentresZ, VitessesX, VitessesY, VitessesZ, Rayons,
+        MateriauxId, PrimitivesId, Noeuds, BoitesFin,
+        NombreSections
+    };
+}
+
+struct EnteteSceneBinaire {
+    char magique[8];
+    uint32_t version;
+    uint32_t boutisme;
+    uint32_t taille_noeud;    // sizeof(NoeudBVH) au moment de l'ecriture
+    uint32_t taille_materiau; // sizeof(MateriauBinaire)
+    uint64_t nombre_spheres;  // les tableaux de la soupe en ont largeur_max de plus
+    uint64_t nombre_materiaux;
+    uint64_t nombre_noeuds;
+    double temps0, temps1;    // intervalle pour lequel les boites des noeuds ont ete calculees
+    uint64_t position[scene_binaire::NombreSections];
+    uint64_t taille[scene_binaire::NombreSections];
+};
+
+inline bool est_scene_binaire(const std::string& nom) {
+    return finit_par(nom, ".rtsb");
+}
+
+class SceneBinaire : public std::enable_shared_from_this<SceneBinaire> {
+public:
+    // Leve std::invalid_argument si le fichier est illisible, tronque ou d'une autre version
+    static std::shared_ptr<SceneBinaire> ouvrir(const std::string& nom);
+
+    ~SceneBinaire() {
+        if (adresse != nullptr) munmap(const_cast<char*>(adresse), taille_fichier);
+    }
+
+    SceneBinaire(const SceneBinaire&) = delete;
+    SceneBinaire& operator=(const SceneBinaire&) = delete;
+
+    const EnteteSceneBinaire& entete() const { return *reinterpret_cast<const EnteteSceneBinaire*>(adresse); }
+
+    std::string parametres() const {
+        return std::string(section<char>(scene_binaire::Parametres), entete().taille[scene_binaire::Parametres]);
+    }
+
+    const MateriauBinaire* materiaux() const { return section<MateriauBinaire>(scene_binaire::Materiaux); }
+    const NoeudBVH* noeuds() const { return section<NoeudBVH>(scene_binaire::Noeuds); }
+
+    // Boites des noeuds a temps1, nul si aucune sphere ne bouge
+    const BoundingBox* boites_fin() const {
+        return entete().taille[scene_binaire::BoitesFin] > 0 ? section<BoundingBox>(scene_binaire::BoitesFin) : nullptr;
+    }
+
+    // Remplit une table vide : l'indice de chaque materiau est celui du fichier
+    void indexer(TableMateriaux& table) const {
+        for (uint64_t i = 0; i < entete().nombre_materiaux; i++)
+            table.enregistrer(materiau::materiau_depuis_binaire(materiaux()[i]));
+    }
+
+    // Soupe lisant directement les tableaux du fichier ; elle garde la projection vivante
+    std::shared_ptr<SoupeSpheres> soupe() const;
+
+    // Objets equivalents, dans l'ordre des primitives, pour l'export XML ou pour modifier la scene.
+    // Une sphere mobile est rendue sur [0, 1] : c(t) = c + t * v, comme dans la soupe.
+    ObjectList vers_liste() const;
+
+private:
+    SceneBinaire() {}
+
+    template <class T> const T* section(int s) const {
+        return reinterpret_cast<const T*>(adresse + entete().position[s]);
+    }
+
+    const char* adresse = nullptr;
+    size_t taille_fichier = 0;
+};
+
+std::shared_ptr<SceneBinaire> SceneBinaire::ouvrir(const std::string& nom) {
+    int fd = open(nom.c_str(), O_RDONLY);
+    if (fd < 0) throw std::invalid_argument("Impossible d'ouvrir la scene binaire " + nom);
+
+    struct stat infos;
+    if (fstat(fd, &infos) != 0 || static_cast<size_t>(infos.st_size) < sizeof(EnteteSceneBinaire)) {
+        close(fd);
+        throw std::invalid_argument("Scene binaire tronquee : " + nom);
+    }
+
+    // Projection privee : les pages ne sont lues qu'au premier acces
+    void* p = mmap(nullptr, infos.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED) throw std::invalid_argument("Impossible de projeter la scene binaire " + nom);
+
+    std::shared_ptr<SceneBinaire> scene(new SceneBinaire());
+    scene->adresse = static_cast<const char*>(p);
+    scene->taille_fichier = infos.st_size;
+
+    const EnteteSceneBinaire& e = scene->entete();
+    if (memcmp(e.magique, scene_binaire::magique, sizeof(e.magique)) != 0)
+        throw std::invalid_argument(nom + " n'est pas une scene binaire");
+    if (e.version != scene_binaire::version || e.boutisme != scene_binaire::controle_boutisme)
+        throw std::invalid_argument("Version ou boutisme de la scene binaire non pris en charge : " + nom);
+    if (e.taille_noeud != sizeof(NoeudBVH) || e.taille_materiau != sizeof(MateriauBinaire))
+        throw std::invalid_argument("Disposition des structures de la scene binaire incompatible : " + nom);
+
+    // Nombres bornes d'abord : les tailles attendues ci-dessous ne peuvent alors pas deborder
+    if (e.nombre_spheres > INT32_MAX || e.nombre_noeuds > INT32_MAX || e.nombre_materiaux > UINT32_MAX)
+        throw std::invalid_argument("Scene binaire corrompue : " + nom);
+
+    const uint64_t spheres = e.nombre_spheres + SoupeSpheres::largeur_max;
+    const uint64_t boites_fin = e.taille[scene_binaire::BoitesFin] > 0 ? e.nombre_noeuds * sizeof(BoundingBox) : 0;
+    const uint64_t attendu[scene_binaire::NombreSections] = {
+        e.taille[scene_binaire::Parametres], e.nombre_materiaux * sizeof(MateriauBinaire),
+        spheres * 8, spheres * 8, spheres * 8, spheres * 8, spheres * 8, spheres * 8, spheres * 8,
+        spheres * 4, spheres * 4, e.nombre_noeuds * sizeof(NoeudBVH), boites_fin
+    };
+    for (int s = 0; s < scene_binaire::NombreSections; s++) {
+        if (e.taille[s] != attendu[s] || e.position[s] % scene_binaire::alignement != 0 ||
+            e.position[s] > scene->taille_fichier || e.taille[s] > scene->taille_fichier - e.position[s])
+            throw std::invalid_argument("Scene binaire corrompue : " + nom);
+    }
+
+    // Les indices lus dans le fichier servent tels quels au rendu : ils doivent designer
+    // un materiau, une primitive et des noeuds existants. Chaque primitive n'a qu'une sphere.
+    for (uint64_t i = 0; i < e.nombre_materiaux; i++) {
+        if (scene->materiaux()[i].type > static_cast<uint32_t>(TypeMateriau::Emissif))
+            throw std::invalid_argument("Scene binaire corrompue : " + nom);
+    }
+    const uint32_t* materiaux_id = scene->section<uint32_t>(scene_binaire::MateriauxId);
+    const uint32_t* primitives_id = scene->section<uint32_t>(scene_binaire::PrimitivesId);
+    std::vector<bool> primitive_vue(e.nombre_spheres, false);
+    for (uint64_t i = 0; i < e.nombre_spheres; i++) {
+        if (materiaux_id[i] >= e.nombre_materiaux || primitives_id[i] >= e.nombre_spheres || primitive_vue[primitives_id[i]])
+            throw std::invalid_argument("Scene binaire corrompue : " + nom);
+        primitive_vue[primitives_id[i]] = true;
+    }
+
+    // Les enfants suivent leur parent (pas de cycle) et l'arbre tient dans la pile du parcours
+    const NoeudBVH* noeuds = scene->noeuds();
+    const int64_t nombre_noeuds = static_cast<int64_t>(e.nombre_noeuds);
+    std::vector<int> profondeur(nombre_noeuds, 0);
+    for (int64_t n = 0; n < nombre_noeuds; n++) {
+        const NoeudBVH& noeud = noeuds[n];
+        bool valide = noeud.axe >= 0 && noeud.axe < 3 && noeud.nombre >= 0;
+        if (valide && noeud.nombre > 0) {
+            valide = noeud.premier >= 0 && static_cast<int64_t>(noeud.premier) + noeud.nombre <= static_cast<int64_t>(e.nombre_spheres);
+        }
+        else if (valide) {
+            valide = n + 1 < nombre_noeuds && noeud.premier > n && noeud.premier < nombre_noeuds
+                  && profondeur[n] < BVH::profondeur_max;
+            if (valide) {
+                profondeur[n + 1] = std::max(profondeur[n + 1], profondeur[n] + 1);
+                profondeur[noeud.premier] = std::max(profondeur[noeud.premier], profondeur[n] + 1);
+            }
+        }
+        if (!valide)
+            throw std::invalid_argument("Scene binaire corrompue : " + nom);
+    }
+    return scene;
+}
+
+std::shared_ptr<SoupeSpheres> SceneBinaire::soupe() const {
+    using namespace scene_binaire;
+    const double* const positions[7] = {
+        section<double>(CentresX), section<double>(CentresY), section<double>(CentresZ),
+        section<double>(VitessesX), section<double>(VitessesY), section<double>(VitessesZ),
+        section<double>(Rayons)
+    };
+    auto s = std::make_shared<SoupeSpheres>();
+    s->adopter(positions, section<uint32_t>(MateriauxId), section<uint32_t>(PrimitivesId),
+               static_cast<int>(entete().nombre_spheres), shared_from_this());
+    return s;
+}
+
+ObjectList SceneBinaire::vers_liste() const {
+    std::vector<shared_ptr<materiau>> table(entete().nombre_materiaux);
+    for (size_t i = 0; i < table.size(); i++)
+        table[i] = materiau::materiau_depuis_binaire(materiaux()[i]);
+
+    auto s = soupe();
+    ObjectList liste;
+    liste.objects.resize(s->nombre());
+    for (int i = 0; i < s->nombre(); i++) {
+        point c(s->cx[i], s->cy[i], s->cz[i]);
+        vecteur3 v(s->vx[i], s->vy[i], s->vz[i]);
+        shared_ptr<materiau> m = table.at(s->materiaux_id[i]);
+        shared_ptr<Object>& objet = liste.objects.at(s->primitives_id[i]);
+        if (v.norme2() > 0)
+            objet = make_shared<Mobile_Sphere>(c, c + v, 0.0, 1.0, s->rayons[i], m);
+        else
+            objet = make_shared<SphereObject>(c, s->rayons[i], m);
+    }
+    return liste;
+}
+
+// Ecrit une scene deja indexee ; le BVH doit porter une soupe de spheres (ou etre vide).
+// Renvoie false si le fichier ne peut pas etre ecrit.
+bool ecrire_scene_binaire(const std::string& nom, const std::string& parametres, const TableMateriaux& materiaux,
+                          const BVH& bvh, double temps0, double temps1) {
+    using namespace scene_binaire;
+    if (bvh.taille_arbre > 0 && !bvh.soupe)
+        throw std::invalid_argument("La scene binaire ne contient que des spheres");
+
+    std::vector<MateriauBinaire> table(materiaux.taille());
+    for (size_t i = 0; i < table.size(); i++)
+        table[i] = materiaux[static_cast<uint32_t>(i)].vers_binaire();
+
+    SoupeSpheres vide;
+    vide.finaliser();
+    const SoupeSpheres& s = bvh.soupe ? *bvh.soupe : vide;
+    const uint64_t spheres = s.nombre() + SoupeSpheres::largeur_max;
+
+    EnteteSceneBinaire e;
+    memset(&e, 0, sizeof(e));
+    memcpy(e.magique, magique, sizeof(e.magique));
+    e.version = version;
+    e.boutisme = controle_boutisme;
+    e.taille_noeud = sizeof(NoeudBVH);
+    e.taille_materiau = sizeof(MateriauBinaire);
+    e.nombre_spheres = s.nombre();
+    e.nombre_materiaux = table.size();
+    e.nombre_noeuds = bvh.taille_arbre;
+    e.temps0 = temps0;
+    e.temps1 = temps1;
+
+    const void* donnees[NombreSections] = {
+        parametres.data(), table.data(),
+        s.cx, s.cy, s.cz, s.vx, s.vy, s.vz, s.rayons,
+        s.materiaux_id, s.primitives_id, bvh.arbre, bvh.arbre_fin
+    };
+    const uint64_t tailles[NombreSections] = {
+        parametres.size(), table.size() * sizeof(MateriauBinaire),
+        spheres * 8, spheres * 8, spheres * 8, spheres * 8, spheres * 8, spheres * 8, spheres * 8,
+        spheres * 4, spheres * 4, e.nombre_noeuds * sizeof(NoeudBVH),
+        bvh.arbre_fin ? e.nombre_noeuds * sizeof(BoundingBox) : 0
+    };
+
+    uint64_t position = sizeof(EnteteSceneBinaire);
+    for (int i = 0; i < NombreSections; i++) {
+        position = (position + alignement - 1) / alignement * alignement;
+        e.position[i] = position;
+        e.taille[i] = tailles[i];
+        position += tailles[i];
+    }
+
+    std::ofstream f(nom, std::ios::binary);
+    if (!f) return false;
+    f.write(reinterpret_cast<const char*>(&e), sizeof(e));
+    for (int i = 0; i < NombreSections; i++) {
+        while (static_cast<uint64_t>(f.tellp()) < e.position[i])
+            f.put('\0');
+        if (tailles[i] > 0)
+            f.write(static_cast<const char*>(donnees[i]), tailles[i]);
+    }
+    return static_cast<bool>(f);
+}
+
+#endif // SCENEBINAIRE_H_INCLUDED
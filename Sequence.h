@@ -0,0 +1,80 @@
+#ifndef SEQUENCE_H_INCLUDED
+#define SEQUENCE_H_INCLUDED
+
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+
+#include "../include/tinyxml2.h"
+
+// Animation rendue image par image dans le meme processus. L'image n commence a
+// n / images_par_seconde et l'obturateur reste ouvert angle_obturation / 360 de la
+// periode d'une image (180 degres : la moitie, comme une camera de cinema).
+struct ParametresSequence {
+    bool actif = false;
+    int premiere = 0, derniere = 0;  // bornes comprises
+    double images_par_seconde = 24;
+    double angle_obturation = 180;
+
+    ParametresSequence() {}
+
+    ParametresSequence(tinyxml2::XMLElement* pElement) {
+        actif = pElement->BoolAttribute("Actif", actif);
+        premiere = pElement->IntAttribute("Premiere", premiere);
+        derniere = pElement->IntAttribute("Derniere", derniere);
+        images_par_seconde = pElement->DoubleAttribute("ImagesParSeconde", images_par_seconde);
+        angle_obturation = pElement->DoubleAttribute("AngleObturation", angle_obturation);
+        verifier();
+    }
+
+    tinyxml2::XMLElement* to_xml(tinyxml2::XMLDocument& xmlDoc) const {
+        tinyxml2::XMLElement * pElement = xmlDoc.NewElement("Sequence");
+        pElement->SetAttribute("Actif", actif);
+        pElement->SetAttribute("Premiere", premiere);
+        pElement->SetAttribute("Derniere", derniere);
+        pElement->SetAttribute("ImagesParSeconde", images_par_seconde);
+        pElement->SetAttribute("AngleObturation", angle_obturation);
+        return pElement;
+    }
+
+    // Leve std::invalid_argument si la plage ou l'obturation n'ont pas de sens
+    void verifier() const {
+        if (premiere < 0 || derniere < premiere)
+            throw std::invalid_argument("Plage d'images de la sequence invalide");
+        if (!(images_par_seconde > 0))
+            throw std::invalid_argument("La sequence doit avoir un nombre d'images par seconde positif");
+        if (angle_obturation < 0 || angle_obturation > 360)
+            throw std::invalid_argument("L'angle d'obturation doit etre compris entre 0 et 360 degres");
+    }
+
+    int nombre_images() const { return derniere - premiere + 1; }
+
+    // Intervalle d'obturation de l'image `image`, en secondes
+    double debut(int image) const { return image / images_par_seconde; }
+    double fin(int image) const { return debut(image) + angle_obturation / 360 / images_par_seconde; }
+};
+
+// Nom du fichier d'une image de la sequence : les '#' consecutifs du modele sont remplaces
+// par le numero complete de zeros ("rendu_####.png" -> "rendu_0012.png") ; sans '#',
+// "_0012" est insere avant l'extension
+std::string nom_image_sequence(const std::string& modele, int image) {
+    size_t debut = modele.find('#');
+    size_t longueur = 0;
+    if (debut == std::string::npos) {
+        size_t point = modele.rfind('.');
+        size_t separateur = modele.find_last_of("/\\");
+        if (point == std::string::npos || (separateur != std::string::npos && point < separateur))
+            point = modele.size();
+        debut = point;
+    }
+    else {
+        while (debut + longueur < modele.size() && modele[debut + longueur] == '#')
+            longueur++;
+    }
+
+    char numero[32];
+    snprintf(numero, sizeof(numero), "%0*d", longueur > 0 ? static_cast<int>(longueur) : 4, image);
+    return modele.substr(0, debut) + (longueur > 0 ? "" : "_") + numero + modele.substr(debut + longueur);
+}
+
+#endif // SEQUENCE_H_INCLUDED
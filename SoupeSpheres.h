@@ -0,0 +1,390 @@
+#ifndef SOUPESPHERES_H_INCLUDED
+#define SOUPESPHERES_H_INCLUDED
+
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <memory>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SOUPE_X86
+#endif
+
+#include "rt.h"
+#include "vecteur3.h"
+#include "rayon.h"
+#include "ObjectHit.h"
+#include "BoundingBox.h"
+#include "sphere.h"
+#include "Mobile_Sphere.h"
+#include "materiau.h"
+
+// Allocateur aligne sur une ligne de cache, pour les chargements vectoriels
+template <class T, std::size_t Alignement = 64>
+struct AllocateurAligne {
+    using value_type = T;
+
+    AllocateurAligne() {}
+    template <class U> AllocateurAligne(const AllocateurAligne<U, Alignement>&) {}
+    template <class U> struct rebind { using other = AllocateurAligne<U, Alignement>; };
+
+    T* allocate(std::size_t n) {
+        std::size_t taille = (n * sizeof(T) + Alignement - 1) / Alignement * Alignement;
+        void* p = std::aligned_alloc(Alignement, taille);
+        if (p == nullptr) throw std::bad_alloc();
+        return static_cast<T*>(p);
+    }
+
+    void deallocate(T* p, std::size_t) { std::free(p); }
+
+    bool operator==(const AllocateurAligne&) const { return true; }
+    bool operator!=(const AllocateurAligne&) const { return false; }
+};
+
+using TableauAligne = std::vector<double, AllocateurAligne<double>>;
+
+// Rayon decompose une fois pour toutes avant les tests par paquets
+struct ParametresRayon {
+    double ox, oy, oz;
+    double dx, dy, dz;
+    double temps;
+    double a;  // norme au carre de la direction
+
+    ParametresRayon(const rayon& r) {
+        point o = r.origine();
+        vecteur3 d = r.direction();
+        ox = o.x(); oy = o.y(); oz = o.z();
+        dx = d.x(); dy = d.y(); dz = d.z();
+        temps = r.temps();
+        a = d.norme2();
+    }
+};
+
+class SoupeSpheres;
+
+// Noyau : teste les spheres [debut, fin), renvoie la plus proche (ou -1) et reduit t_max
+using NoyauSoupe = int (*)(const SoupeSpheres&, const ParametresRayon&, int, int, double, double&);
+
+// Spheres fixes et mobiles compilees en tableaux alignes (SoA). Le centre d'une sphere
+// a l'instant t vaut c + t * v ; v est nul pour une sphere fixe. Les spheres doivent
+// avoir ete indexees (Object::indexer) : la soupe reprend leurs identifiants.
+// Les tableaux sont lus a travers des pointeurs : ils appartiennent a la soupe, ou a une
+// scene binaire projetee en memoire (voir adopter()).
+class SoupeSpheres {
+public:
+    // Largeur du plus grand paquet : les tableaux sont prolonges d'autant pour que
+    // le dernier paquet d'une plage puisse etre charge sans debordement
+    static const int largeur_max = 8;
+
+    SoupeSpheres() {}
+
+    // Les pointeurs designent les tableaux de l'instance : une copie les partagerait
+    SoupeSpheres(const SoupeSpheres&) = delete;
+    SoupeSpheres& operator=(const SoupeSpheres&) = delete;
+
+    void ajouter(const point& c, const vecteur3& v, double r, uint32_t materiau_id, uint32_t primitive_id);
+    void ajouter(const SphereObject& s);
+    void ajouter(const Mobile_Sphere& s);
+
+    // Ajoute l'objet s'il s'agit d'une sphere ; renvoie false sinon
+    bool ajouter(const Object& objet);
+
+    void finaliser();
+
+    // Utilise en place des tableaux deja prolonges de largeur_max elements ; `proprietaire`
+    // garde leur memoire vivante aussi longtemps que la soupe
+    void adopter(const double* const positions[7], const uint32_t* materiaux, const uint32_t* primitives,
+                 int nombre, std::shared_ptr<const void> proprietaire);
+
+    int nombre() const { return nombre_spheres; }
+
+    point centre(int indice, double temps) const {
+        return point(cx[indice] + temps * vx[indice], cy[indice] + temps * vy[indice], cz[indice] + temps * vz[indice]);
+    }
+
+    // Boite balayee par la sphere `indice` entre time0 et time1
+    BoundingBox boite(int indice, double time0, double time1) const {
+        vecteur3 r(rayons[indice], rayons[indice], rayons[indice]);
+        point c0 = centre(indice, time0), c1 = centre(indice, time1);
+        return creer_surrounding_box(BoundingBox(c0 - r, c0 + r), BoundingBox(c1 - r, c1 + r));
+    }
+
+    int intersect_plage(const ParametresRayon& p, int debut, int fin, double t_min, double& t_max) const {
+        return noyau(*this, p, debut, fin, t_min, t_max);
+    }
+
+    // Complete l'enregistrement pour la sphere `indice` touchee a la distance t
+    void remplir(const rayon& r, int indice, double t, EnregIntersect& record) const;
+
+    // Largeur des paquets du noyau choisi pour ce processeur (2, 4 ou 8)
+    static int largeurPaquet();
+    static const char* nomJeuInstructions();
+
+public:
+    // Valides apres finaliser() ou adopter()
+    const double *cx = nullptr, *cy = nullptr, *cz = nullptr;
+    const double *vx = nullptr, *vy = nullptr, *vz = nullptr;
+    const double *rayons = nullptr;
+    const uint32_t *materiaux_id = nullptr;
+    const uint32_t *primitives_id = nullptr;
+
+private:
+    // Tableaux possedes par la soupe, remplis par ajouter()
+    TableauAligne tab_cx, tab_cy, tab_cz;
+    TableauAligne tab_vx, tab_vy, tab_vz;
+    TableauAligne tab_rayons;
+    std::vector<uint32_t> tab_materiaux_id;
+    std::vector<uint32_t> tab_primitives_id;
+    std::shared_ptr<const void> memoire_externe;
+
+    static NoyauSoupe choisirNoyau();
+    static inline const NoyauSoupe noyau = choisirNoyau();
+
+    int nombre_spheres = 0;
+};
+
+void SoupeSpheres::ajouter(const point& c, const vecteur3& v, double r, uint32_t materiau_id, uint32_t primitive_id) {
+    tab_cx.push_back(c.x()); tab_cy.push_back(c.y()); tab_cz.push_back(c.z());
+    tab_vx.push_back(v.x()); tab_vy.push_back(v.y()); tab_vz.push_back(v.z());
+    tab_rayons.push_back(r);
+    tab_materiaux_id.push_back(materiau_id);
+    tab_primitives_id.push_back(primitive_id);
+    nombre_spheres++;
+}
+
+void SoupeSpheres::ajouter(const SphereObject& s) {
+    ajouter(s.center, vecteur3(0, 0, 0), s.radius, s.materiau_id, s.primitive_id);
+}
+
+void SoupeSpheres::ajouter(const Mobile_Sphere& s) {
+    // Un intervalle vide donne une sphere immobile, comme dans la table des lumieres
+    vecteur3 vitesse = s.time1 > s.time0 ? (s.center1 - s.center0) / (s.time1 - s.time0) : vecteur3(0, 0, 0);
+    ajouter(s.center0 - s.time0 * vitesse, vitesse, s.radius, s.materiau_id, s.primitive_id);
+}
+
+bool SoupeSpheres::ajouter(const Object& objet) {
+    if (auto s = dynamic_cast<const SphereObject*>(&objet)) {
+        ajouter(*s);
+        return true;
+    }
+    if (auto s = dynamic_cast<const Mobile_Sphere*>(&objet)) {
+        ajouter(*s);
+        return true;
+    }
+    return false;
+}
+
+void SoupeSpheres::finaliser() {
+    for (auto* t : {&tab_cx, &tab_cy, &tab_cz, &tab_vx, &tab_vy, &tab_vz, &tab_rayons})
+        t->resize(nombre_spheres + largeur_max, 0.0);
+    tab_materiaux_id.resize(nombre_spheres + largeur_max, 0);
+    tab_primitives_id.resize(nombre_spheres + largeur_max, 0);
+
+    cx = tab_cx.data(); cy = tab_cy.data(); cz = tab_cz.data();
+    vx = tab_vx.data(); vy = tab_vy.data(); vz = tab_vz.data();
+    rayons = tab_rayons.data();
+    materiaux_id = tab_materiaux_id.data();
+    primitives_id = tab_primitives_id.data();
+}
+
+void SoupeSpheres::adopter(const double* const positions[7], const uint32_t* materiaux, const uint32_t* primitives,
+                           int nombre, std::shared_ptr<const void> proprietaire) {
+    cx = positions[0]; cy = positions[1]; cz = positions[2];
+    vx = positions[3]; vy = positions[4]; vz = positions[5];
+    rayons = positions[6];
+    materiaux_id = materiaux;
+    primitives_id = primitives;
+    nombre_spheres = nombre;
+    memoire_externe = std::move(proprietaire);
+}
+
+void SoupeSpheres::remplir(const rayon& r, int indice, double t, EnregIntersect& record) const {
+    record.t = t;
+    record.p = r.pt_a_distance(t);
+    vecteur3 surface_normal_at_intersection = (record.p - centre(indice, r.temps())) / rayons[indice];
+    record.compute_face_normal(r, surface_normal_at_intersection);
+    record.materiau_id = materiaux_id[indice];
+    record.primitive_id = primitives_id[indice];
+}
+
+// Version scalaire : reference, et repli hors x86
+int intersect_soupe_scalaire(const SoupeSpheres& s, const ParametresRayon& p, int debut, int fin, double t_min, double& t_max) {
+    int meilleur = -1;
+    for (int i = debut; i < fin; i++) {
+        double ocx = p.ox - (s.cx[i] + p.temps * s.vx[i]);
+        double ocy = p.oy - (s.cy[i] + p.temps * s.vy[i]);
+        double ocz = p.oz - (s.cz[i] + p.temps * s.vz[i]);
+        double half = ocx * p.dx + ocy * p.dy + ocz * p.dz;
+        double c = ocx * ocx + ocy * ocy + ocz * ocz - s.rayons[i] * s.rayons[i];
+        double discr = half * half - p.a * c;
+        if (discr < 0) continue;
+        double sqrtD = sqrt(discr);
+
+        double root = (-half - sqrtD) / p.a;
+        if (root < t_min || t_max < root) {
+            root = (-half + sqrtD) / p.a;
+            if (root < t_min || t_max < root)
+                continue;
+        }
+        t_max = root;
+        meilleur = i;
+    }
+    return meilleur;
+}
+
+#ifdef SOUPE_X86
+
+// Les racines de chaque voie sont calculees en parallele ; la reduction vers la plus proche
+// est scalaire et parcourt les voies dans l'ordre, comme la version scalaire.
+#define SOUPE_REDUIRE(W)                                                   \
+    for (int k = 0; k < W && i + k < fin; k++) {                           \
+        if ((masque >> k & 1) && racines[k] <= t_max) {                    \
+            t_max = racines[k];                                            \
+            meilleur = i + k;                                              \
+        }                                                                  \
+    }
+
+int intersect_soupe_sse2(const SoupeSpheres& s, const ParametresRayon& p, int debut, int fin, double t_min, double& t_max) {
+    const __m128d ox = _mm_set1_pd(p.ox), oy = _mm_set1_pd(p.oy), oz = _mm_set1_pd(p.oz);
+    const __m128d dx = _mm_set1_pd(p.dx), dy = _mm_set1_pd(p.dy), dz = _mm_set1_pd(p.dz);
+    const __m128d temps = _mm_set1_pd(p.temps), a = _mm_set1_pd(p.a), zero = _mm_setzero_pd();
+    const __m128d tmin = _mm_set1_pd(t_min);
+    alignas(16) double racines[2];
+    int meilleur = -1;
+
+    for (int i = debut; i < fin; i += 2) {
+        __m128d ocx = _mm_sub_pd(ox, _mm_add_pd(_mm_loadu_pd(&s.cx[i]), _mm_mul_pd(temps, _mm_loadu_pd(&s.vx[i]))));
+        __m128d ocy = _mm_sub_pd(oy, _mm_add_pd(_mm_loadu_pd(&s.cy[i]), _mm_mul_pd(temps, _mm_loadu_pd(&s.vy[i]))));
+        __m128d ocz = _mm_sub_pd(oz, _mm_add_pd(_mm_loadu_pd(&s.cz[i]), _mm_mul_pd(temps, _mm_loadu_pd(&s.vz[i]))));
+        __m128d r = _mm_loadu_pd(&s.rayons[i]);
+
+        __m128d half = _mm_add_pd(_mm_add_pd(_mm_mul_pd(ocx, dx), _mm_mul_pd(ocy, dy)), _mm_mul_pd(ocz, dz));
+        __m128d c = _mm_sub_pd(_mm_add_pd(_mm_add_pd(_mm_mul_pd(ocx, ocx), _mm_mul_pd(ocy, ocy)), _mm_mul_pd(ocz, ocz)), _mm_mul_pd(r, r));
+        __m128d discr = _mm_sub_pd(_mm_mul_pd(half, half), _mm_mul_pd(a, c));
+        __m128d existe = _mm_cmpge_pd(discr, zero);
+        __m128d sqrtD = _mm_sqrt_pd(_mm_max_pd(discr, zero));
+
+        __m128d tmax = _mm_set1_pd(t_max);
+        __m128d r1 = _mm_div_pd(_mm_sub_pd(_mm_sub_pd(zero, half), sqrtD), a);
+        __m128d r2 = _mm_div_pd(_mm_add_pd(_mm_sub_pd(zero, half), sqrtD), a);
+        __m128d ok1 = _mm_and_pd(existe, _mm_and_pd(_mm_cmpge_pd(r1, tmin), _mm_cmple_pd(r1, tmax)));
+        __m128d ok2 = _mm_and_pd(existe, _mm_and_pd(_mm_cmpge_pd(r2, tmin), _mm_cmple_pd(r2, tmax)));
+        __m128d racine = _mm_or_pd(_mm_and_pd(ok1, r1), _mm_andnot_pd(ok1, r2));
+
+        int masque = _mm_movemask_pd(_mm_or_pd(ok1, ok2));
+        if (masque == 0) continue;
+        _mm_store_pd(racines, racine);
+        SOUPE_REDUIRE(2)
+    }
+    return meilleur;
+}
+
+__attribute__((target("avx2,fma")))
+int intersect_soupe_avx2(const SoupeSpheres& s, const ParametresRayon& p, int debut, int fin, double t_min, double& t_max) {
+    const __m256d ox = _mm256_set1_pd(p.ox), oy = _mm256_set1_pd(p.oy), oz = _mm256_set1_pd(p.oz);
+    const __m256d dx = _mm256_set1_pd(p.dx), dy = _mm256_set1_pd(p.dy), dz = _mm256_set1_pd(p.dz);
+    const __m256d temps = _mm256_set1_pd(p.temps), a = _mm256_set1_pd(p.a), zero = _mm256_setzero_pd();
+    const __m256d tmin = _mm256_set1_pd(t_min);
+    alignas(32) double racines[4];
+    int meilleur = -1;
+
+    for (int i = debut; i < fin; i += 4) {
+        __m256d ocx = _mm256_sub_pd(ox, _mm256_fmadd_pd(temps, _mm256_loadu_pd(&s.vx[i]), _mm256_loadu_pd(&s.cx[i])));
+        __m256d ocy = _mm256_sub_pd(oy, _mm256_fmadd_pd(temps, _mm256_loadu_pd(&s.vy[i]), _mm256_loadu_pd(&s.cy[i])));
+        __m256d ocz = _mm256_sub_pd(oz, _mm256_fmadd_pd(temps, _mm256_loadu_pd(&s.vz[i]), _mm256_loadu_pd(&s.cz[i])));
+        __m256d r = _mm256_loadu_pd(&s.rayons[i]);
+
+        __m256d half = _mm256_fmadd_pd(ocz, dz, _mm256_fmadd_pd(ocy, dy, _mm256_mul_pd(ocx, dx)));
+        __m256d c = _mm256_fmsub_pd(ocz, ocz, _mm256_fmsub_pd(r, r, _mm256_fmadd_pd(ocy, ocy, _mm256_mul_pd(ocx, ocx))));
+        __m256d discr = _mm256_fmsub_pd(half, half, _mm256_mul_pd(a, c));
+        __m256d existe = _mm256_cmp_pd(discr, zero, _CMP_GE_OQ);
+        __m256d sqrtD = _mm256_sqrt_pd(_mm256_max_pd(discr, zero));
+
+        __m256d tmax = _mm256_set1_pd(t_max);
+        __m256d r1 = _mm256_div_pd(_mm256_sub_pd(_mm256_sub_pd(zero, half), sqrtD), a);
+        __m256d r2 = _mm256_div_pd(_mm256_add_pd(_mm256_sub_pd(zero, half), sqrtD), a);
+        __m256d ok1 = _mm256_and_pd(existe, _mm256_and_pd(_mm256_cmp_pd(r1, tmin, _CMP_GE_OQ), _mm256_cmp_pd(r1, tmax, _CMP_LE_OQ)));
+        __m256d ok2 = _mm256_and_pd(existe, _mm256_and_pd(_mm256_cmp_pd(r2, tmin, _CMP_GE_OQ), _mm256_cmp_pd(r2, tmax, _CMP_LE_OQ)));
+        __m256d racine = _mm256_blendv_pd(r2, r1, ok1);
+
+        int masque = _mm256_movemask_pd(_mm256_or_pd(ok1, ok2));
+        if (masque == 0) continue;
+        _mm256_store_pd(racines, racine);
+        SOUPE_REDUIRE(4)
+    }
+    return meilleur;
+}
+
+__attribute__((target("avx512f")))
+int intersect_soupe_avx512(const SoupeSpheres& s, const ParametresRayon& p, int debut, int fin, double t_min, double& t_max) {
+    const __m512d ox = _mm512_set1_pd(p.ox), oy = _mm512_set1_pd(p.oy), oz = _mm512_set1_pd(p.oz);
+    const __m512d dx = _mm512_set1_pd(p.dx), dy = _mm512_set1_pd(p.dy), dz = _mm512_set1_pd(p.dz);
+    const __m512d temps = _mm512_set1_pd(p.temps), a = _mm512_set1_pd(p.a), zero = _mm512_setzero_pd();
+    const __m512d tmin = _mm512_set1_pd(t_min);
+    alignas(64) double racines[8];
+    int meilleur = -1;
+
+    for (int i = debut; i < fin; i += 8) {
+        __m512d ocx = _mm512_sub_pd(ox, _mm512_fmadd_pd(temps, _mm512_loadu_pd(&s.vx[i]), _mm512_loadu_pd(&s.cx[i])));
+        __m512d ocy = _mm512_sub_pd(oy, _mm512_fmadd_pd(temps, _mm512_loadu_pd(&s.vy[i]), _mm512_loadu_pd(&s.cy[i])));
+        __m512d ocz = _mm512_sub_pd(oz, _mm512_fmadd_pd(temps, _mm512_loadu_pd(&s.vz[i]), _mm512_loadu_pd(&s.cz[i])));
+        __m512d r = _mm512_loadu_pd(&s.rayons[i]);
+
+        __m512d half = _mm512_fmadd_pd(ocz, dz, _mm512_fmadd_pd(ocy, dy, _mm512_mul_pd(ocx, dx)));
+        __m512d c = _mm512_fmsub_pd(ocz, ocz, _mm512_fmsub_pd(r, r, _mm512_fmadd_pd(ocy, ocy, _mm512_mul_pd(ocx, ocx))));
+        __m512d discr = _mm512_fmsub_pd(half, half, _mm512_mul_pd(a, c));
+        __mmask8 existe = _mm512_cmp_pd_mask(discr, zero, _CMP_GE_OQ);
+        __m512d sqrtD = _mm512_sqrt_pd(_mm512_max_pd(discr, zero));
+
+        __m512d tmax = _mm512_set1_pd(t_max);
+        __m512d r1 = _mm512_div_pd(_mm512_sub_pd(_mm512_sub_pd(zero, half), sqrtD), a);
+        __m512d r2 = _mm512_div_pd(_mm512_add_pd(_mm512_sub_pd(zero, half), sqrtD), a);
+        __mmask8 ok1 = existe & _mm512_cmp_pd_mask(r1, tmin, _CMP_GE_OQ) & _mm512_cmp_pd_mask(r1, tmax, _CMP_LE_OQ);
+        __mmask8 ok2 = existe & _mm512_cmp_pd_mask(r2, tmin, _CMP_GE_OQ) & _mm512_cmp_pd_mask(r2, tmax, _CMP_LE_OQ);
+        __m512d racine = _mm512_mask_blend_pd(ok1, r2, r1);
+
+        int masque = ok1 | ok2;
+        if (masque == 0) continue;
+        _mm512_store_pd(racines, racine);
+        SOUPE_REDUIRE(8)
+    }
+    return meilleur;
+}
+
+#undef SOUPE_REDUIRE
+
+#endif // SOUPE_X86
+
+NoyauSoupe SoupeSpheres::choisirNoyau() {
+#ifdef SOUPE_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) return intersect_soupe_avx512;
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) return intersect_soupe_avx2;
+    return intersect_soupe_sse2;
+#else
+    return intersect_soupe_scalaire;
+#endif
+}
+
+int SoupeSpheres::largeurPaquet() {
+#ifdef SOUPE_X86
+    if (noyau == intersect_soupe_avx512) return 8;
+    if (noyau == intersect_soupe_avx2) return 4;
+    return 2;
+#else
+    return 1;
+#endif
+}
+
+const char* SoupeSpheres::nomJeuInstructions() {
+    switch (largeurPaquet()) {
+        case 8: return "AVX-512";
+        case 4: return "AVX2";
+        case 2: return "SSE2";
+        default: return "scalaire";
+    }
+}
+
+#endif // SOUPESPHERES_H_INCLUDED
@@ -0,0 +1,145 @@
+#ifndef STATISTIQUES_H_INCLUDED
+#define STATISTIQUES_H_INCLUDED
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <deque>
+#include <iomanip>
+#include <mutex>
+#include <ostream>
+#include <sstream>
+#include <string>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+// Ce que comptent les integrateurs et les accelerateurs. Les requetes (touches/rates) sont
+// les parcours complets du monde, rayons d'ombre compris ; les tests sont les primitives
+// testees pendant ces parcours. Chaque chemin se termine d'une seule des quatre facons.
+enum Compteur {
+    RayonsCamera, RayonsRebond, RayonsOmbre,
+    TestsIntersection, Touches, Rates,
+    FinsProfondeur, FinsCiel, FinsRoulette, FinsAbsorption,
+    TempsActifNs,  // temps passe par les threads dans les tuiles
+    NombreCompteurs
+};
+
+inline const char* nom_compteur(Compteur c) {
+    static const char* const noms[NombreCompteurs] = {
+        "rayons_camera", "rayons_rebond", "rayons_ombre",
+        "tests_intersection", "touches", "rates",
+        "fins_profondeur", "fins_ciel", "fins_roulette", "fins_absorption",
+        "temps_actif_ns"
+    };
+    return noms[c];
+}
+
+// Compteurs d'un thread, seuls sur leurs lignes de cache : deux threads n'ecrivent jamais
+// dans la meme ligne. Seul le thread proprietaire ecrit ; les lectures des autres threads
+// (totaux pendant le rendu) passent par des atomiques relaches, sans instruction verrouillee.
+struct alignas(64) CompteursThread {
+    std::atomic<uint64_t> valeurs[NombreCompteurs] = {};
+
+    void ajouter(Compteur c, uint64_t n = 1) {
+        valeurs[c].store(valeurs[c].load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+};
+
+// Totaux, a un instant donne, de tous les threads qui ont compte quelque chose
+struct TotauxStatistiques {
+    uint64_t valeurs[NombreCompteurs] = {};
+
+    uint64_t operator[](Compteur c) const { return valeurs[c]; }
+
+    uint64_t rayons() const { return valeurs[RayonsCamera] + valeurs[RayonsRebond] + valeurs[RayonsOmbre]; }
+
+    // Segments par chemin, rayon de camera compris
+    double longueur_moyenne() const {
+        return valeurs[RayonsCamera] > 0 ? double(valeurs[RayonsCamera] + valeurs[RayonsRebond]) / valeurs[RayonsCamera] : 0;
+    }
+
+    // Part du temps de `threads` threads pendant `duree` secondes passee a rendre des tuiles
+    double utilisation(double duree, int threads) const {
+        return duree > 0 && threads > 0 ? valeurs[TempsActifNs] * 1e-9 / (duree * threads) : 0;
+    }
+};
+
+class Statistiques {
+public:
+    // Compteurs du thread appelant, crees a sa premiere utilisation et jamais liberes
+    static CompteursThread& locaux() {
+        if (courant == nullptr) {
+            std::lock_guard<std::mutex> l(verrou);
+            courant = &blocs.emplace_back();
+        }
+        return *courant;
+    }
+
+    static TotauxStatistiques totaux() {
+        TotauxStatistiques t;
+        std::lock_guard<std::mutex> l(verrou);
+        for (const CompteursThread& c : blocs)
+            for (int i = 0; i < NombreCompteurs; i++)
+                t.valeurs[i] += c.valeurs[i].load(std::memory_order_relaxed);
+        return t;
+    }
+
+    // A appeler entre deux rendus, quand aucun thread ne compte
+    static void remettre_a_zero() {
+        std::lock_guard<std::mutex> l(verrou);
+        for (CompteursThread& c : blocs)
+            for (int i = 0; i < NombreCompteurs; i++)
+                c.valeurs[i].store(0, std::memory_order_relaxed);
+    }
+
+private:
+    static inline std::mutex verrou;
+    static inline std::deque<CompteursThread> blocs;  // une deque ne deplace pas ses elements
+    static inline thread_local CompteursThread* courant = nullptr;
+};
+
+// Compteur de cycles du processeur (TSC), pour mesurer de courtes durees sans appel systeme ;
+// nanosecondes d'une horloge monotone sur les autres architectures
+inline uint64_t lire_cycles() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+namespace json {
+    inline std::string chaine(const std::string& s) {
+        std::string r = "\"";
+        for (char c : s) {
+            if (c == '"' || c == '\\') r += '\\';
+            if (static_cast<unsigned char>(c) >= 0x20) r += c;
+        }
+        return r + "\"";
+    }
+
+    // Les valeurs negatives (absentes) deviennent null
+    inline std::string nombre(double x) {
+        if (x < 0 || !std::isfinite(x)) return "null";
+        std::ostringstream s;
+        s << std::setprecision(9) << x;
+        return s.str();
+    }
+}
+
+// Objet JSON d'une ligne : compteurs bruts puis debits, pour un rendu de `duree` secondes
+void ecrire_json_statistiques(std::ostream& f, const TotauxStatistiques& t, double duree, int threads) {
+    f << "{";
+    for (int i = 0; i < NombreCompteurs; i++)
+        f << json::chaine(nom_compteur(static_cast<Compteur>(i))) << ": " << t.valeurs[i] << ", ";
+    f << "\"rayons\": " << t.rayons()
+      << ", \"duree_s\": " << json::nombre(duree)
+      << ", \"mrayons_par_s\": " << json::nombre(duree > 0 ? t.rayons() / duree / 1e6 : -1)
+      << ", \"longueur_moyenne\": " << json::nombre(t.longueur_moyenne())
+      << ", \"utilisation_threads\": " << json::nombre(t.utilisation(duree, threads)) << "}";
+}
+
+#endif // STATISTIQUES_H_INCLUDED
@@ -0,0 +1,177 @@
+#ifndef TRACE_H_INCLUDED
+#define TRACE_H_INCLUDED
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Trace des phases du rendu au format Chrome trace-event (chrome://tracing, ui.perfetto.dev).
+// Desactivee, une portee ne coute qu'un test d'atomique. Activee, chaque thread ecrit ses
+// evenements dans son propre tampon circulaire : les plus anciens sont ecrases s'il deborde.
+// Le tampon d'un thread termine est repris par le prochain thread de meme nom : les threads
+// recrees a chaque rendu ne font pas grossir la trace.
+
+struct EvenementTrace {
+    const char* nom;         // chaine litterale
+    uint64_t debut_ns;       // depuis l'origine de la trace
+    uint64_t duree_ns;
+    const char* cles[2];     // arguments optionnels, nullptr si absents
+    int64_t valeurs[2];
+};
+
+class Trace {
+public:
+    static const size_t capacite = 1 << 16;  // evenements par thread
+
+    static bool actif() { return active.load(std::memory_order_relaxed); }
+
+    static void activer(bool valeur) {
+        if (valeur) origine();
+        active.store(valeur, std::memory_order_relaxed);
+    }
+
+    // Nom du thread appelant dans la trace
+    static void nommer_thread(const std::string& nom) {
+        nom_thread = nom;
+        if (courant != nullptr) {
+            std::lock_guard<std::mutex> l(verrou);
+            courant->nom = nom;
+            courant->cle = nom;
+        }
+    }
+
+    static uint64_t maintenant_ns() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - origine()).count();
+    }
+
+    static void enregistrer(const EvenementTrace& e) {
+        Tampon& t = locaux();
+        uint64_t n = t.ecrits.load(std::memory_order_relaxed);
+        t.evenements[n % capacite] = e;
+        t.ecrits.store(n + 1, std::memory_order_release);
+    }
+
+    // A appeler quand aucun thread n'enregistre plus (fin du rendu, fin du programme)
+    static bool exporter(const std::string& nom_fichier);
+
+private:
+    struct Tampon {
+        std::vector<EvenementTrace> evenements;
+        std::atomic<uint64_t> ecrits{0};
+        std::string nom;
+        std::string cle;     // nom donne par le thread, vide s'il n'en a pas
+        int identifiant;
+        bool libre = false;  // son thread est termine ; sous verrou
+    };
+
+    // Rend le tampon du thread quand celui-ci se termine
+    struct Liberation {
+        Tampon* tampon;
+        Liberation() : tampon(nullptr) {}
+        ~Liberation() {
+            if (tampon == nullptr) return;
+            std::lock_guard<std::mutex> l(verrou);
+            tampon->libre = true;
+        }
+    };
+
+    static std::chrono::steady_clock::time_point origine() {
+        static const std::chrono::steady_clock::time_point t = std::chrono::steady_clock::now();
+        return t;
+    }
+
+    static Tampon& locaux() {
+        if (courant == nullptr) {
+            std::lock_guard<std::mutex> l(verrou);
+            for (Tampon& t : tampons) {
+                if (t.libre && t.cle == nom_thread) {
+                    t.libre = false;
+                    courant = &t;
+                    break;
+                }
+            }
+            if (courant == nullptr) {
+                Tampon& t = tampons.emplace_back();
+                t.evenements.resize(capacite);
+                t.identifiant = static_cast<int>(tampons.size());
+                t.nom = nom_thread.empty() ? "thread " + std::to_string(t.identifiant) : nom_thread;
+                t.cle = nom_thread;
+                courant = &t;
+            }
+            liberation.tampon = courant;
+        }
+        return *courant;
+    }
+
+    static inline std::atomic<bool> active{false};
+    static inline std::mutex verrou;
+    static inline std::deque<Tampon> tampons;  // une deque ne deplace pas ses elements
+    static inline thread_local Tampon* courant = nullptr;
+    static inline thread_local std::string nom_thread;
+    static inline thread_local Liberation liberation;
+};
+
+bool Trace::exporter(const std::string& nom_fichier) {
+    std::ofstream f(nom_fichier);
+    if (!f) return false;
+
+    std::lock_guard<std::mutex> l(verrou);
+    uint64_t perdus = 0;
+    f << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+    bool premier = true;
+    for (const Tampon& t : tampons) {
+        f << (premier ? "" : ",\n") << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << t.identifiant
+          << ", \"args\": {\"name\": \"" << t.nom << "\"}}";
+        premier = false;
+
+        const uint64_t ecrits = t.ecrits.load(std::memory_order_acquire);
+        const uint64_t debut = ecrits > capacite ? ecrits - capacite : 0;
+        perdus += debut;
+        char tampon[64];
+        for (uint64_t i = debut; i < ecrits; i++) {
+            const EvenementTrace& e = t.evenements[i % capacite];
+            // Les temps sont en microsecondes
+            snprintf(tampon, sizeof(tampon), "%.3f, \"dur\": %.3f", e.debut_ns * 1e-3, e.duree_ns * 1e-3);
+            f << ",\n{\"name\": \"" << e.nom << "\", \"ph\": \"X\", \"pid\": 1, \"tid\": " << t.identifiant << ", \"ts\": " << tampon;
+            if (e.cles[0] != nullptr) {
+                f << ", \"args\": {\"" << e.cles[0] << "\": " << e.valeurs[0];
+                if (e.cles[1] != nullptr) f << ", \"" << e.cles[1] << "\": " << e.valeurs[1];
+                f << "}";
+            }
+            f << "}";
+        }
+    }
+    f << "\n], \"otherData\": {\"evenements_perdus\": " << perdus << "}}\n";
+    return static_cast<bool>(f);
+}
+
+// Enregistre la duree de sa portee sous `nom` si la trace est active
+class PorteeTrace {
+public:
+    explicit PorteeTrace(const char* nom, const char* cle0 = nullptr, int64_t valeur0 = 0,
+                         const char* cle1 = nullptr, int64_t valeur1 = 0) {
+        if (!Trace::actif()) return;
+        evenement = {nom, Trace::maintenant_ns(), 0, {cle0, cle1}, {valeur0, valeur1}};
+        active = true;
+    }
+
+    ~PorteeTrace() {
+        if (!active) return;
+        evenement.duree_ns = Trace::maintenant_ns() - evenement.debut_ns;
+        Trace::enregistrer(evenement);
+    }
+
+    PorteeTrace(const PorteeTrace&) = delete;
+    PorteeTrace& operator=(const PorteeTrace&) = delete;
+
+private:
+    EvenementTrace evenement;
+    bool active = false;
+};
+
+#endif // TRACE_H_INCLUDED
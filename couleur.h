@@ -1,54 +1,168 @@
-#ifndef COULEUR_H_INCLUDED
-#define COULEUR_H_INCLUDED
-#include <algorithm>
-#include "vecteur3.h"
-#include "rt.h"
-#include <SFML/Graphics.hpp>
-#include <vector>
-
-#include <iostream>
-
-class Couleur {
-public:
-    double r, g, b;
-
-    Couleur(double rouge, double vert, double bleu) : r(rouge), g(vert), b(bleu) {}
-
-    void restreindre() {
-        r = std::clamp(r, 0.0, 1.0);
-        g = std::clamp(g, 0.0, 1.0);
-        b = std::clamp(b, 0.0, 1.0);
-    }
-
-    // Divise la couleur par le nombre d'chantillons
-    void mettre_a_echelle(double echelle) {
-        r *= echelle;
-        g *= echelle;
-        b *= echelle;
-    }
-
-    // Applique une correction gamma (lvation  la puissance 1/2.2)
-    void corriger_gamma() {
-        r = std::pow(r, 1.0 / 2.2);
-        g = std::pow(g, 1.0 / 2.2);
-        b = std::pow(b, 1.0 / 2.2);
-    }
-};
-
-// Fonction write_color mise  jour pour utiliser la classe Couleur
-void entrer_couleur(std::vector<sf::Uint8> &pix, Couleur coul_pix, int ech_par_pix, int lig, int col,
-                 int larg_im) {
-    coul_pix.restreindre();        // Assurer que les composantes de couleur sont dans la plage [0.0, 1.0]
-    coul_pix.mettre_a_echelle(1.0 / ech_par_pix);  // Diviser par le nombre d'chantillons
-    coul_pix.corriger_gamma();  // Appliquer la correction gamma
-
-    // Convertir et crire dans le vecteur de pixels
-    pixels[(lig * larg_im+ col) * 4] = static_cast<sf::Uint8>(255 * coul_pix.r);
-    pixels[(lig * larg_im + col) * 4 + 1] = static_cast<sf::Uint8>(255 * coul_pix.g);
-    pixels[(lig * larg_im+ col) * 4 + 2] = static_cast<sf::Uint8>(255 * coul_pix.b);
-    pixels[(lig * larg_im + col) * 4 + 3] = 255; // Canal alpha
-}
-
-
-
-#endif // COULEUR_H_INCLUDED
+#ifndef COULEUR_H_INCLUDED
+#define COULEUR_H_INCLUDED
+#include <algorithm>
+#include <cmath>
+#include "vecteur3.h"
+#include "rt.h"
+#include <SFML/Graphics.hpp>
+#include <vector>
+#include <cstring>
+#include <cstdint>
+
+#include <iostream>
+
+class Couleur {
+public:
+    double r, g, b;
+
+    Couleur(double rouge, double vert, double bleu) : r(rouge), g(vert), b(bleu) {}
+
+    void restreindre() {
+        r = std::clamp(r, 0.0, 1.0);
+        g = std::clamp(g, 0.0, 1.0);
+        b = std::clamp(b, 0.0, 1.0);
+    }
+
+    // Divise la couleur par le nombre d'échantillons
+    void mettre_a_echelle(double echelle) {
+        r *= echelle;
+        g *= echelle;
+        b *= echelle;
+    }
+
+    // Applique une correction gamma (élévation à la puissance 1/2.2)
+    void corriger_gamma() {
+        r = std::pow(r, 1.0 / 2.2);
+        g = std::pow(g, 1.0 / 2.2);
+        b = std::pow(b, 1.0 / 2.2);
+    }
+};
+
+// Fonction write_color mise à jour pour utiliser la classe Couleur
+void entrer_couleur(std::vector<sf::Uint8> &pix, Couleur coul_pix, int ech_par_pix, int lig, int col,
+                 int larg_im) {
+    coul_pix.mettre_a_echelle(1.0 / ech_par_pix);  // Diviser par le nombre d'échantillons
+    coul_pix.restreindre();        // Assurer que les composantes de couleur sont dans la plage [0.0, 1.0]
+    coul_pix.corriger_gamma();  // Appliquer la correction gamma
+
+    // Convertir et écrire dans le vecteur de pixels
+    pix[(lig * larg_im+ col) * 4] = static_cast<sf::Uint8>(255 * coul_pix.r);
+    pix[(lig * larg_im + col) * 4 + 1] = static_cast<sf::Uint8>(255 * coul_pix.g);
+    pix[(lig * larg_im+ col) * 4 + 2] = static_cast<sf::Uint8>(255 * coul_pix.b);
+    pix[(lig * larg_im + col) * 4 + 3] = 255; // Canal alpha
+}
+
+// Courbes de compression de la dynamique, appliquees apres l'exposition
+enum class Tonemap { Aucun, Reinhard, ACES };
+
+inline const char* nom_tonemap(Tonemap t) {
+    switch (t) {
+        case Tonemap::Reinhard: return "Reinhard";
+        case Tonemap::ACES:     return "ACES";
+        default:                return "Aucun";
+    }
+}
+
+inline Tonemap tonemap_depuis_nom(const char* nom) {
+    if (nom != nullptr && strcmp(nom, "Reinhard") == 0) return Tonemap::Reinhard;
+    if (nom != nullptr && strcmp(nom, "ACES") == 0) return Tonemap::ACES;
+    return Tonemap::Aucun;
+}
+
+// Réglages appliqués à la radiance seulement au moment de l'affichage ou de l'enregistrement
+struct ParametresResolution {
+    double exposition = 0;          // en diaphragmes (EV)
+    Tonemap tonemap = Tonemap::Aucun;
+    double gamma = 0;               // 0 : courbe sRGB
+};
+
+// Convertit des sommes de radiance RVB en pixels RGBA 8 bits. Si `echantillons` est nul,
+// `rgb` contient déjà des moyennes. Le travail est fait par blocs, une étape à la fois,
+// pour que chaque boucle reste simple et vectorisable.
+void resoudre_pixels(const float* rgb, const uint32_t* echantillons, int nombre_pixels,
+                     const ParametresResolution& parametres, sf::Uint8* rgba) {
+    // Courbe de transfert tabulée sur [0, 1]
+    const int taille_table = 1 << 14;
+    std::vector<sf::Uint8> table(taille_table);
+    for (int k = 0; k < taille_table; k++) {
+        double x = k / (taille_table - 1.0);
+        double y = parametres.gamma > 0 ? std::pow(x, 1.0 / parametres.gamma)
+                 : x <= 0.0031308 ? 12.92 * x : 1.055 * std::pow(x, 1.0 / 2.4) - 0.055;
+        table[k] = static_cast<sf::Uint8>(255 * y + 0.5);
+    }
+
+    const float gain = static_cast<float>(std::exp2(parametres.exposition));
+    const int taille_bloc = 256;
+    float bloc[3 * taille_bloc];
+    float echelle[taille_bloc];
+
+    for (int debut = 0; debut < nombre_pixels; debut += taille_bloc) {
+        const int n = std::min(taille_bloc, nombre_pixels - debut);
+        const float* source = rgb + 3 * static_cast<size_t>(debut);
+
+        // Moyenne et exposition ; un pixel sans échantillon reste noir
+        for (int k = 0; k < n; k++)
+            echelle[k] = echantillons == nullptr ? gain : echantillons[debut + k] > 0 ? gain / echantillons[debut + k] : 0.0f;
+        for (int k = 0; k < 3 * n; k++)
+            bloc[k] = source[k] * echelle[k / 3];
+
+        switch (parametres.tonemap) {
+            case Tonemap::Reinhard:
+                for (int k = 0; k < 3 * n; k++)
+                    bloc[k] = bloc[k] / (1.0f + bloc[k]);
+                break;
+            case Tonemap::ACES:
+                // Ajustement de Narkowicz
+                for (int k = 0; k < 3 * n; k++) {
+                    float x = bloc[k];
+                    bloc[k] = (x * (2.51f * x + 0.03f)) / (x * (2.43f * x + 0.59f) + 0.14f);
+                }
+                break;
+            default:
+                break;
+        }
+
+        // Une valeur non finie (NaN d'un echantillon, inf/inf du tonemap) devient noire :
+        // std::clamp laisserait passer NaN jusqu'a l'indice de la table
+        for (int k = 0; k < 3 * n; k++) {
+            float x = std::isfinite(bloc[k]) && bloc[k] > 0 ? std::min(bloc[k], 1.0f) : 0.0f;
+            bloc[k] = x * (taille_table - 1) + 0.5f;
+        }
+
+        sf::Uint8* destination = rgba + 4 * static_cast<size_t>(debut);
+        for (int k = 0; k < n; k++) {
+            destination[4 * k] = table[static_cast<int>(bloc[3 * k])];
+            destination[4 * k + 1] = table[static_cast<int>(bloc[3 * k + 1])];
+            destination[4 * k + 2] = table[static_cast<int>(bloc[3 * k + 2])];
+            destination[4 * k + 3] = 255;
+        }
+    }
+}
+
+// Fausses couleurs (noir, bleu, magenta, orange, jaune, blanc) pour le canal 0 de `valeurs`,
+// qui en compte `canaux` par pixel. L'echelle est lineaire jusqu'au 99e centile, pour qu'un
+// pixel isole tres couteux ne rende pas le reste de la carte noir.
+void carte_chaleur(const float* valeurs, int canaux, int nombre_pixels, sf::Uint8* rgba) {
+    static const float paliers[6][3] = {
+        {0, 0, 0}, {0.1f, 0.1f, 0.6f}, {0.7f, 0.1f, 0.6f}, {1, 0.5f, 0.1f}, {1, 0.9f, 0.2f}, {1, 1, 1}
+    };
+    if (nombre_pixels <= 0) return;
+
+    std::vector<float> tries(nombre_pixels);
+    for (int k = 0; k < nombre_pixels; k++)
+        tries[k] = valeurs[static_cast<size_t>(k) * canaux];
+    auto centile = tries.begin() + (nombre_pixels - 1) * 99 / 100;
+    std::nth_element(tries.begin(), centile, tries.end());
+    const float maximum = *centile > 0 ? *centile : 1.0f;
+
+    for (int k = 0; k < nombre_pixels; k++) {
+        float t = std::clamp(valeurs[static_cast<size_t>(k) * canaux] / maximum, 0.0f, 1.0f) * 5;
+        int i = std::min(4, static_cast<int>(t));
+        float f = t - i;
+        for (int c = 0; c < 3; c++)
+            rgba[4 * k + c] = static_cast<sf::Uint8>(255 * (paliers[i][c] + f * (paliers[i + 1][c] - paliers[i][c])) + 0.5f);
+        rgba[4 * k + 3] = 255;
+    }
+}
+
+#endif // COULEUR_H_INCLUDED
@@ -1,100 +1,670 @@
-#include "Fenetre.hpp"
-#include <SFML/Graphics.hpp>
-#include <SFML/System.hpp>
-#include <thread>
-#include <iostream>
-#include <array>
-#include <cstring>
-#include <X11/Xlib.h>
-#include "MoteurDeRendu.h"
-#include "InterfaceTerminal.h"
-
-auto rapport_aspect = 3.0 / 2.0;
-unsigned int largeur_image = 400;
-unsigned int hauteur_image = static_cast<unsigned int>(largeur_image / rapport_aspect);
-
-int principal(int argc, char *argv[])
-{
-    char fichier_origine[40], fichier_dest[40], fichier_image_dest[40];
-    bool a_fichier_origine = false, a_fichier_dest=false, sauvegarder_image=false;
-
-    if (argc > 1) {
-        for (auto i = 1; i < argc; i++) {
-            if (strncmp(argv[i], "--origine=", 10) == 0) {
-                strcpy(fichier_origine, argv[i]+10);
-                a_fichier_origine = true;
-                // std::cout << "Geting file from " << argv[i]+10 << std::endl;
-            }
-            else if (strncmp(argv[i], "--dest=", 7) == 0) {
-                strcpy(fichier_dest, argv[i]+7);
-                a_fichier_dest=true;
-            }
-            else if (strncmp(argv[i], "--sauvegarder-image=", 20) == 0) {
-                strcpy(fichier_image_dest, argv[i]+20);
-                sauvegarder_image=true;
-            }
-        }
-    }
-
-    XInitThreads();
-
-    // window.setActive(false);
-
-    //Moteur rtMoteur(texture, largeur_image, hauteur_image);
-    MoteurRendu rtMoteur;
-    if (a_fichier_origine) {
-        rtMoteur = MoteurRendu(fichier_origine);
-    }
-    else {
-        rtMoteur = MoteurRendu();
-    }
-
-    sf::Sprite sprite(rtMoteur.getTexture());
-
-    sf::VideoMode mode_video(rtMoteur.obtenirLargeurImage(), rtMoteur.obtenirHauteurImage());
-    sf::RenderWindow fenetre(mode_video, "Moteur de Trac de Rayons", sf::Style::Default & (~sf::Style::Close));
-    fenetre.setVisible(false);
-
-    InterfaceTerminal terminal(fenetre, rtMoteur);
-    terminal.initialiser();
-
-
-    // excuter le programme tant que la fentre est ouverte
-    while (!terminal.estTempsDeFermer())
-    {
-        // vrifier tous les vnements de la fentre qui ont t dclenchs depuis la dernire itration de la boucle
-        sf::Event evenement;
-        while (fenetre.pollEvent(evenement))
-        {
-            // vnement "demande de fermeture" : masquer la fentre
-            if (evenement.type == sf::Event::Closed) {
-                // fenetre.close();
-                fenetre.setVisible(false);
-            }
-        }
-
-        if (rtMoteur.estEnTravail()) {
-            fenetre.clear();
-            fenetre.setVisible(false);
-            rtMoteur.rendreImage();
-            fenetre.setVisible(true);
-            fenetre.draw(sprite);
-            fenetre.display();
-        }
-    }
-    fenetre.close();
-
-    if (a_fichier_dest) {
-        // std::cout << "Saving file to " << fichier_dest << std::endl;
-        rtMoteur.sauvegarderDocumentXml(fichier_dest);
-    }
-    if (sauvegarder_image) {
-        // std::cout << "Saving image to " << fichier_image_dest << std::endl;
-        rtMoteur.getTexture().copyToImage().saveToFile(fichier_image_dest);
-    }
-
-    terminal.fermer();
-
-
-    return 0;
-}
+#include "Fenetre.hpp"
+#include <SFML/Graphics.hpp>
+#include <SFML/System.hpp>
+#include <thread>
+#include <iostream>
+#include <fstream>
+#include <array>
+#include <cstring>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <X11/Xlib.h>
+#include "MoteurDeRendu.h"
+#include "InterfaceTerminal.h"
+#include "BancRendu.h"
+#include "RenduDistribue.h"
+#include "RenduPartiel.h"
+
+auto rapport_aspect = 3.0 / 2.0;
+unsigned int largeur_image = 400;
+unsigned int hauteur_image = static_cast<unsigned int>(largeur_image / rapport_aspect);
+
+// Options lues sur la ligne de commande
+struct Options {
+    std::string fichier_origine, fichier_dest, fichier_image_dest;
+    bool a_fichier_origine = false, a_fichier_dest = false, sauvegarder_image = false;
+
+    // Mode sans interface (aucune fenetre, ni X11, ni ncurses)
+    bool batch = false;
+    // Statistiques du rendu en JSON a la fin du mode batch ; sortie standard si --stats= est absent
+    std::string fichier_stats;
+    // Trace des phases et des tuiles (chrome://tracing, Perfetto), ecrite a la sortie
+    std::string fichier_trace;
+    // Charge --origine= et l'enregistre dans --dest= sans rendre ; une destination .rtsb donne une scene binaire
+    bool convertir = false;
+    int echantillons = 0, profondeur = 0, threads = 0;
+    std::string echantillonneur;
+
+    // Reglages de la resolution ; --regrader= les applique a une image .pfm ou .exr deja rendue
+    std::string fichier_regrader;
+    bool a_exposition = false, a_tonemap = false, a_gamma = false;
+    ParametresResolution resolution;
+
+    // Debruitage guide par les AOV ; --aov=<prefixe> enregistre aussi albedo, normale et profondeur
+    bool debruiter = false;
+    std::string prefixe_aov;
+
+    // Carte du cout de rendu par pixel, a cote de l'image : <image>_cout.pfm et <image>_cout.png
+    bool carte_cout = false;
+
+    // Sequence d'images en mode batch (--sequence=premiere:derniere) ; les '#' de l'image
+    // de destination recoivent le numero de chaque image
+    bool a_sequence = false;
+    int premiere_image = 0, derniere_image = 0;
+    double images_par_seconde = 0, angle_obturation = -1;
+    // Accumulation temporelle entre les images ; --temporel-echantillons= fixe les echantillons neufs des pixels repris
+    bool temporel = false;
+    int echantillons_temporels = 0;
+
+    // Rendu distribue : --coordinateur=<adresse> fait rendre l'image par les processus lances
+    // avec --noeud=<adresse> ; --taille-region= fixe le cote des regions qui leur sont confiees
+    bool coordinateur = false, noeud = false;
+    OptionsDistribue distribue;
+
+    // Rendus partiels (.rtpart, sommes et nombres d'echantillons) : --partiel=<fichier> en plus
+    // ou a la place de l'image ; --fusionner=a.rtpart,b.rtpart additionne des rendus faits avec
+    // des graines differentes (--graine=) puis enregistre l'image ou un nouveau rendu partiel
+    std::string fichier_partiel;
+    std::vector<std::string> partiels_a_fusionner;
+    bool a_graine = false;
+    uint64_t graine = 0;
+
+    // Banc d'essai sur le corpus de scenes ; --bench-references rend les images de reference
+    bool bench = false;
+    OptionsBanc banc;
+};
+
+ParametresResolution appliquerOptionsResolution(const Options& options, ParametresResolution resolution)
+{
+    if (options.a_exposition) resolution.exposition = options.resolution.exposition;
+    if (options.a_tonemap) resolution.tonemap = options.resolution.tonemap;
+    if (options.a_gamma) resolution.gamma = options.resolution.gamma;
+    return resolution;
+}
+
+// "rendus/image.png" -> "rendus/image" ; un point dans un nom de dossier n'est pas une extension
+std::string sansExtension(const std::string& nom)
+{
+    size_t point = nom.rfind('.');
+    size_t separateur = nom.find_last_of("/\\");
+    if (point == std::string::npos || (separateur != std::string::npos && point < separateur))
+        return nom;
+    return nom.substr(0, point);
+}
+
+// Refait la resolution d'une image en radiance sans relancer le rendu.
+// Codes de sortie : 0 succes, 1 lecture impossible, 2 echec d'enregistrement.
+int regrader(const Options& options)
+{
+    if (!options.sauvegarder_image) {
+        std::cerr << "--regrader requiert --sauvegarder-image=<fichier>" << std::endl;
+        return 1;
+    }
+
+    std::vector<float> radiance;
+    int largeur, hauteur;
+    if (!lire_image_hdr(options.fichier_regrader, radiance, largeur, hauteur)) {
+        std::cerr << "Impossible de lire l'image " << options.fichier_regrader << std::endl;
+        return 1;
+    }
+
+    if (est_image_hdr(options.fichier_image_dest))
+        return ecrire_image_hdr(options.fichier_image_dest, radiance, largeur, hauteur) ? 0 : 2;
+
+    std::vector<sf::Uint8> pixels(4 * static_cast<size_t>(largeur) * hauteur);
+    resoudre_pixels(radiance.data(), nullptr, largeur * hauteur, appliquerOptionsResolution(options, ParametresResolution()), pixels.data());
+
+    sf::Image image;
+    image.create(largeur, hauteur, pixels.data());
+    if (!image.saveToFile(options.fichier_image_dest)) {
+        std::cerr << "Impossible d'enregistrer l'image " << options.fichier_image_dest << std::endl;
+        return 2;
+    }
+    return 0;
+}
+
+// Convertit une scene d'un format a l'autre (XML ou binaire .rtsb, d'apres les extensions).
+// Codes de sortie : 0 succes, 1 arguments ou scene invalides, 2 echec d'enregistrement.
+int convertir(const Options& options)
+{
+    if (!options.a_fichier_origine || !options.a_fichier_dest) {
+        std::cerr << "--convertir requiert --origine=<fichier> et --dest=<fichier>" << std::endl;
+        return 1;
+    }
+
+    try {
+        MoteurRendu rtMoteur(options.fichier_origine.c_str());
+        if (!rtMoteur.sauvegarderScene(options.fichier_dest.c_str())) {
+            std::cerr << "Impossible d'enregistrer la scene " << options.fichier_dest << std::endl;
+            return 2;
+        }
+    }
+    catch (std::exception& e) {
+        std::cerr << "Erreur de conversion de " << options.fichier_origine << " : " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+// Charge la scene du mode batch et lui applique les options de la ligne de commande ; 1 si la scene est invalide
+int chargerMoteur(const Options& options, MoteurRendu& rtMoteur)
+{
+    try {
+        if (options.a_fichier_origine)
+            rtMoteur = MoteurRendu(options.fichier_origine.c_str());
+    }
+    catch (std::exception& e) {
+        std::cerr << "Erreur de chargement de " << options.fichier_origine << " : " << e.what() << std::endl;
+        return 1;
+    }
+
+    if (options.echantillons > 0) rtMoteur.definirEchantillonsParPixel(options.echantillons);
+    if (options.profondeur > 0) rtMoteur.definirProfondeurMax(options.profondeur);
+    if (options.threads > 0) rtMoteur.definirNombreThreads(options.threads);
+    if (options.a_graine) rtMoteur.definirGraine(options.graine);
+    if (!options.echantillonneur.empty()) rtMoteur.definirEchantillonneur(echantillonneur_depuis_nom(options.echantillonneur.c_str()));
+    rtMoteur.definirResolution(appliquerOptionsResolution(options, rtMoteur.obtenirResolution()));
+    if (options.debruiter) {
+        ParametresDebruitage debruitage = rtMoteur.obtenirDebruitage();
+        debruitage.actif = true;
+        rtMoteur.definirDebruitage(debruitage);
+    }
+    rtMoteur.definirCollecteAOV(!options.prefixe_aov.empty());
+    rtMoteur.definirCollecteCout(options.carte_cout);
+    return 0;
+}
+
+// Enregistre la scene dans --dest= ; une scene binaire ne peut contenir que des spheres.
+// 0 succes, 2 echec d'enregistrement.
+int enregistrerScene(const Options& options, MoteurRendu& rtMoteur)
+{
+    try {
+        if (rtMoteur.sauvegarderScene(options.fichier_dest.c_str())) return 0;
+        std::cerr << "Impossible d'enregistrer la scene " << options.fichier_dest << std::endl;
+    }
+    catch (std::exception& e) {
+        std::cerr << "Erreur d'enregistrement de " << options.fichier_dest << " : " << e.what() << std::endl;
+    }
+    return 2;
+}
+
+// Enregistre l'image, les AOV, la carte de cout et le rendu partiel demandes ; un nom vide est ignore.
+// 0 succes, 2 echec d'enregistrement.
+int enregistrerSorties(const Options& options, const MoteurRendu& rtMoteur, const std::string& image, const std::string& prefixe_aov,
+                       const std::string& partiel)
+{
+    if (!partiel.empty() && !ecrire_rendu_partiel(partiel, extraire_rendu_partiel(rtMoteur))) {
+        std::cerr << "Impossible d'enregistrer le rendu partiel " << partiel << std::endl;
+        return 2;
+    }
+    if (image.empty()) {
+        if (!prefixe_aov.empty() && !rtMoteur.sauvegarderAOV(prefixe_aov)) {
+            std::cerr << "Impossible d'enregistrer les AOV " << prefixe_aov << std::endl;
+            return 2;
+        }
+        return 0;
+    }
+    if (!rtMoteur.sauvegarderImage(image.c_str())) {
+        std::cerr << "Impossible d'enregistrer l'image " << image << std::endl;
+        return 2;
+    }
+    if (!prefixe_aov.empty() && !rtMoteur.sauvegarderAOV(prefixe_aov)) {
+        std::cerr << "Impossible d'enregistrer les AOV " << prefixe_aov << std::endl;
+        return 2;
+    }
+    if (options.carte_cout && !rtMoteur.sauvegarderCout(sansExtension(image))) {
+        std::cerr << "Impossible d'enregistrer la carte de cout de " << image << std::endl;
+        return 2;
+    }
+    return 0;
+}
+
+// Rend la scene directement depuis le tampon de pixels puis quitte.
+// Codes de sortie : 0 succes, 1 arguments ou scene invalides, 2 echec d'enregistrement.
+int rendreEnLot(const Options& options)
+{
+    if (!options.sauvegarder_image && options.fichier_partiel.empty()) {
+        std::cerr << "--batch requiert --sauvegarder-image=<fichier> ou --partiel=<fichier>" << std::endl;
+        return 1;
+    }
+
+    MoteurRendu rtMoteur;
+    if (chargerMoteur(options, rtMoteur) != 0) return 1;
+
+    ParametresSequence sequence = rtMoteur.obtenirSequence();
+    if (options.a_sequence) {
+        sequence.actif = true;
+        sequence.premiere = options.premiere_image;
+        sequence.derniere = options.derniere_image;
+    }
+    if (options.images_par_seconde > 0) sequence.images_par_seconde = options.images_par_seconde;
+    if (options.angle_obturation >= 0) sequence.angle_obturation = options.angle_obturation;
+    try {
+        sequence.verifier();
+    }
+    catch (std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    rtMoteur.definirSequence(sequence);
+
+    ParametresTemporel temporel = rtMoteur.obtenirTemporel();
+    if (options.temporel) temporel.actif = true;
+    if (options.echantillons_temporels > 0) temporel.echantillons = options.echantillons_temporels;
+    rtMoteur.definirTemporel(temporel);
+    if (temporel.actif && !options.fichier_partiel.empty()) {
+        std::cerr << "Un rendu partiel ne peut pas contenir l'historique de l'accumulation temporelle" << std::endl;
+        return 1;
+    }
+
+    // Une ligne JSON de statistiques par image
+    std::ofstream fichier_stats;
+    if (!options.fichier_stats.empty()) fichier_stats.open(options.fichier_stats);
+    std::ostream& stats = options.fichier_stats.empty() ? std::cout : fichier_stats;
+
+    // Sans sequence, une seule image avec l'obturation de la camera. Avec, la scene, le pool
+    // de threads et le BVH restent charges d'une image a l'autre.
+    const int premiere = sequence.actif ? sequence.premiere : 0;
+    const int derniere = sequence.actif ? sequence.derniere : 0;
+    const double debut_obturation = rtMoteur.obtenirDebutObturation(), fin_obturation = rtMoteur.obtenirFinObturation();
+    for (int numero = premiere; numero <= derniere; numero++) {
+        PorteeTrace trace("image", "image", numero);
+        std::string image = options.fichier_image_dest;
+        std::string prefixe_aov = options.prefixe_aov;
+        std::string partiel = options.fichier_partiel;
+        if (sequence.actif) {
+            rtMoteur.definirImageSequence(numero);
+            if (!image.empty()) image = nom_image_sequence(image, numero);
+            if (!prefixe_aov.empty()) prefixe_aov = nom_image_sequence(prefixe_aov, numero);
+            if (!partiel.empty()) partiel = nom_image_sequence(partiel, numero);
+        }
+
+        rtMoteur.commencerTravail();
+        rtMoteur.creerImage();
+
+        if (int code = enregistrerSorties(options, rtMoteur, image, prefixe_aov, partiel)) return code;
+
+        ecrire_json_statistiques(stats, Statistiques::totaux(), rtMoteur.obtenirDureeRendu(), rtMoteur.obtenirNombreThreads());
+        stats << std::endl;
+        if (!stats) {
+            std::cerr << "Impossible d'enregistrer les statistiques " << options.fichier_stats << std::endl;
+            return 2;
+        }
+    }
+
+    // --dest enregistre la camera de la scene, pas l'obturation de la derniere image
+    rtMoteur.definirObturation(debut_obturation, fin_obturation);
+    if (options.a_fichier_dest) return enregistrerScene(options, rtMoteur);
+    return 0;
+}
+
+// Coordonne le rendu d'une image par des noeuds de calcul (--noeud=) puis l'enregistre.
+// Codes de sortie : 0 succes, 1 arguments, scene ou adresse invalides, 2 echec d'enregistrement,
+// 3 image incomplete faute de noeuds.
+int rendreDistribue(const Options& options)
+{
+    if (!options.sauvegarder_image && options.fichier_partiel.empty()) {
+        std::cerr << "--coordinateur requiert --sauvegarder-image=<fichier> ou --partiel=<fichier>" << std::endl;
+        return 1;
+    }
+    if (options.a_sequence || options.temporel) {
+        std::cerr << "Le rendu distribue ne rend qu'une image, sans accumulation temporelle" << std::endl;
+        return 1;
+    }
+
+    MoteurRendu rtMoteur;
+    if (chargerMoteur(options, rtMoteur) != 0) return 1;
+    ParametresTemporel temporel = rtMoteur.obtenirTemporel();
+    temporel.actif = false;
+    rtMoteur.definirTemporel(temporel);
+
+    try {
+        if (!coordonner_rendu(rtMoteur, options.distribue, std::cerr)) return 3;
+    }
+    catch (std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    std::cerr << "Rendu distribue en " << rtMoteur.obtenirDureeRendu() << " s" << std::endl;
+
+    if (int code = enregistrerSorties(options, rtMoteur, options.fichier_image_dest, options.prefixe_aov, options.fichier_partiel))
+        return code;
+    if (options.a_fichier_dest) return enregistrerScene(options, rtMoteur);
+    return 0;
+}
+
+// Additionne des rendus partiels de la meme scene : chaque pixel recoit la somme des echantillons
+// de tous les fichiers, divisee par leur nombre total. Un fichier illisible ou tronque (noeud
+// interrompu) est ignore avec un avertissement.
+// Codes de sortie : 0 succes, 1 aucun rendu lisible, rendus incompatibles ou de meme graine, 2 echec d'enregistrement.
+int fusionner(const Options& options)
+{
+    if (!options.sauvegarder_image && options.fichier_partiel.empty()) {
+        std::cerr << "--fusionner requiert --sauvegarder-image=<fichier> ou --partiel=<fichier>" << std::endl;
+        return 1;
+    }
+
+    RenduPartiel somme;
+    int lus = 0;
+    for (const std::string& nom : options.partiels_a_fusionner) {
+        RenduPartiel partiel;
+        try {
+            partiel = lire_rendu_partiel(nom);
+        }
+        catch (std::exception& e) {
+            std::cerr << e.what() << ", ignore" << std::endl;
+            continue;
+        }
+        try {
+            if (lus == 0) somme = std::move(partiel);
+            else ajouter_rendu_partiel(somme, partiel);
+        }
+        catch (std::exception& e) {
+            std::cerr << nom << " : " << e.what() << std::endl;
+            return 1;
+        }
+        lus++;
+    }
+    if (lus == 0) {
+        std::cerr << "Aucun rendu partiel lisible" << std::endl;
+        return 1;
+    }
+
+    MoteurRendu rtMoteur(1, 1);
+    try {
+        charger_rendu_partiel(rtMoteur, somme);
+    }
+    catch (std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    rtMoteur.definirResolution(appliquerOptionsResolution(options, rtMoteur.obtenirResolution()));
+    if (options.debruiter) {
+        ParametresDebruitage debruitage = rtMoteur.obtenirDebruitage();
+        debruitage.actif = true;
+        rtMoteur.definirDebruitage(debruitage);
+    }
+    std::cerr << lus << " rendu(s) partiel(s) fusionne(s)" << std::endl;
+
+    // La somme garde l'empreinte de ses rendus : ce moteur n'a pas la scene pour la recalculer
+    if (!options.fichier_partiel.empty() && !ecrire_rendu_partiel(options.fichier_partiel, somme)) {
+        std::cerr << "Impossible d'enregistrer le rendu partiel " << options.fichier_partiel << std::endl;
+        return 2;
+    }
+    return enregistrerSorties(options, rtMoteur, options.fichier_image_dest, options.prefixe_aov, "");
+}
+
+int principal(int argc, char *argv[])
+{
+    Options options;
+
+    if (argc > 1) {
+        for (auto i = 1; i < argc; i++) {
+            if (strncmp(argv[i], "--origine=", 10) == 0) {
+                options.fichier_origine = argv[i]+10;
+                options.a_fichier_origine = true;
+                // std::cout << "Geting file from " << argv[i]+10 << std::endl;
+            }
+            else if (strncmp(argv[i], "--dest=", 7) == 0) {
+                options.fichier_dest = argv[i]+7;
+                options.a_fichier_dest=true;
+            }
+            else if (strncmp(argv[i], "--sauvegarder-image=", 20) == 0) {
+                options.fichier_image_dest = argv[i]+20;
+                options.sauvegarder_image=true;
+            }
+            else if (strcmp(argv[i], "--batch") == 0) {
+                options.batch = true;
+            }
+            else if (strncmp(argv[i], "--stats=", 8) == 0) {
+                options.fichier_stats = argv[i]+8;
+            }
+            else if (strncmp(argv[i], "--trace=", 8) == 0) {
+                options.fichier_trace = argv[i]+8;
+            }
+            else if (strcmp(argv[i], "--convertir") == 0) {
+                options.convertir = true;
+            }
+            else if (strncmp(argv[i], "--echantillons=", 15) == 0) {
+                options.echantillons = atoi(argv[i]+15);
+            }
+            else if (strncmp(argv[i], "--profondeur=", 13) == 0) {
+                options.profondeur = atoi(argv[i]+13);
+            }
+            else if (strncmp(argv[i], "--threads=", 10) == 0) {
+                options.threads = atoi(argv[i]+10);
+            }
+            else if (strncmp(argv[i], "--echantillonneur=", 18) == 0) {
+                options.echantillonneur = argv[i]+18;
+            }
+            else if (strcmp(argv[i], "--debruiter") == 0) {
+                options.debruiter = true;
+            }
+            else if (strcmp(argv[i], "--carte-cout") == 0) {
+                options.carte_cout = true;
+            }
+            else if (strncmp(argv[i], "--sequence=", 11) == 0) {
+                options.a_sequence = sscanf(argv[i]+11, "%d:%d", &options.premiere_image, &options.derniere_image) == 2;
+                if (!options.a_sequence) {
+                    std::cerr << "--sequence attend premiere:derniere" << std::endl;
+                    return 1;
+                }
+            }
+            else if (strncmp(argv[i], "--ips=", 6) == 0) {
+                options.images_par_seconde = atof(argv[i]+6);
+            }
+            else if (strncmp(argv[i], "--obturation=", 13) == 0) {
+                options.angle_obturation = atof(argv[i]+13);
+            }
+            else if (strcmp(argv[i], "--temporel") == 0) {
+                options.temporel = true;
+            }
+            else if (strncmp(argv[i], "--temporel-echantillons=", 24) == 0) {
+                options.temporel = true;
+                options.echantillons_temporels = atoi(argv[i]+24);
+            }
+            else if (strncmp(argv[i], "--aov=", 6) == 0) {
+                options.prefixe_aov = argv[i]+6;
+            }
+            else if (strncmp(argv[i], "--coordinateur=", 15) == 0) {
+                options.coordinateur = true;
+                options.distribue.adresse = argv[i]+15;
+            }
+            else if (strncmp(argv[i], "--noeud=", 8) == 0) {
+                options.noeud = true;
+                options.distribue.adresse = argv[i]+8;
+            }
+            else if (strncmp(argv[i], "--partiel=", 10) == 0) {
+                options.fichier_partiel = argv[i]+10;
+            }
+            else if (strncmp(argv[i], "--fusionner=", 12) == 0) {
+                std::string liste = argv[i]+12;
+                for (size_t debut = 0, fin; debut <= liste.size(); debut = fin + 1) {
+                    fin = std::min(liste.find(',', debut), liste.size());
+                    if (fin > debut) options.partiels_a_fusionner.push_back(liste.substr(debut, fin - debut));
+                }
+            }
+            else if (strncmp(argv[i], "--graine=", 9) == 0) {
+                options.graine = strtoull(argv[i]+9, nullptr, 10);
+                options.a_graine = true;
+            }
+            else if (strncmp(argv[i], "--taille-region=", 16) == 0) {
+                options.distribue.taille_region = atoi(argv[i]+16);
+            }
+            else if (strcmp(argv[i], "--bench") == 0) {
+                options.bench = true;
+            }
+            else if (strcmp(argv[i], "--bench-references") == 0) {
+                options.bench = true;
+                options.banc.references = true;
+            }
+            else if (strncmp(argv[i], "--bench-scenes=", 15) == 0) {
+                options.banc.dossier = argv[i]+15;
+            }
+            else if (strncmp(argv[i], "--bench-sortie=", 15) == 0) {
+                options.banc.sortie = argv[i]+15;
+            }
+            else if (strncmp(argv[i], "--regrader=", 11) == 0) {
+                options.fichier_regrader = argv[i]+11;
+            }
+            else if (strncmp(argv[i], "--exposition=", 13) == 0) {
+                options.resolution.exposition = atof(argv[i]+13);
+                options.a_exposition = true;
+            }
+            else if (strncmp(argv[i], "--tonemap=", 10) == 0) {
+                options.resolution.tonemap = tonemap_depuis_nom(argv[i]+10);
+                options.a_tonemap = true;
+            }
+            else if (strncmp(argv[i], "--gamma=", 8) == 0) {
+                options.resolution.gamma = atof(argv[i]+8);
+                options.a_gamma = true;
+            }
+        }
+    }
+
+    if (!options.fichier_trace.empty()) {
+        Trace::activer(true);
+        Trace::nommer_thread("principal");
+    }
+    // La trace est exportee a la sortie, quel que soit le mode
+    auto terminer = [&options](int code) {
+        if (!options.fichier_trace.empty() && !Trace::exporter(options.fichier_trace)) {
+            std::cerr << "Impossible d'enregistrer la trace " << options.fichier_trace << std::endl;
+            return code == 0 ? 2 : code;
+        }
+        return code;
+    };
+
+    if (!options.fichier_regrader.empty()) {
+        return terminer(regrader(options));
+    }
+
+    if (options.convertir) {
+        return terminer(convertir(options));
+    }
+
+    if (options.bench) {
+        options.banc.threads = options.threads;
+        return terminer(executer_bancs(options.banc));
+    }
+
+    if (!options.partiels_a_fusionner.empty()) {
+        return terminer(fusionner(options));
+    }
+
+    if (options.coordinateur) {
+        return terminer(rendreDistribue(options));
+    }
+
+    if (options.noeud) {
+        options.distribue.threads = options.threads;
+        return terminer(executer_noeud(options.distribue, std::cerr));
+    }
+
+    if (options.batch) {
+        return terminer(rendreEnLot(options));
+    }
+
+    XInitThreads();
+
+    // window.setActive(false);
+
+    //Moteur rtMoteur(texture, largeur_image, hauteur_image);
+    MoteurRendu rtMoteur;
+    if (options.a_fichier_origine) {
+        rtMoteur = MoteurRendu(options.fichier_origine.c_str());
+    }
+    else {
+        rtMoteur = MoteurRendu();
+    }
+    // Les guides sont toujours collectés pour pouvoir activer le débruitage après coup
+    rtMoteur.definirCollecteAOV(true);
+    if (options.debruiter) {
+        ParametresDebruitage debruitage = rtMoteur.obtenirDebruitage();
+        debruitage.actif = true;
+        rtMoteur.definirDebruitage(debruitage);
+    }
+
+    sf::Sprite sprite(rtMoteur.getTexture());
+
+    sf::VideoMode mode_video(rtMoteur.obtenirLargeurImage(), rtMoteur.obtenirHauteurImage());
+    sf::RenderWindow fenetre(mode_video, "Moteur de Tracé de Rayons", sf::Style::Default & (~sf::Style::Close));
+    fenetre.setVisible(false);
+
+    InterfaceTerminal terminal(fenetre, rtMoteur);
+    terminal.initialiser();
+
+
+    // Le rendu tourne dans son propre thread ; la boucle principale affiche chaque passe terminée
+    std::thread threadRendu;
+
+    // exécuter le programme tant que la fenêtre est ouverte
+    while (!terminal.estTempsDeFermer())
+    {
+        // vérifier tous les événements de la fenêtre qui ont été déclenchés depuis la dernière itération de la boucle
+        sf::Event evenement;
+        while (fenetre.pollEvent(evenement))
+        {
+            // événement "demande de fermeture" : masquer la fenêtre
+            if (evenement.type == sf::Event::Closed) {
+                // fenetre.close();
+                fenetre.setVisible(false);
+            }
+            // Echap : abandonner le rendu en cours à la fin de la passe
+            else if (evenement.type == sf::Event::KeyPressed && evenement.key.code == sf::Keyboard::Escape) {
+                rtMoteur.interrompre();
+            }
+            // D : activer ou couper le débruitage de l'image terminée
+            else if (evenement.type == sf::Event::KeyPressed && evenement.key.code == sf::Keyboard::D && !threadRendu.joinable()) {
+                ParametresDebruitage debruitage = rtMoteur.obtenirDebruitage();
+                debruitage.actif = !debruitage.actif;
+                rtMoteur.definirDebruitage(debruitage);
+            }
+        }
+
+        if (rtMoteur.estEnTravail() && !threadRendu.joinable()) {
+            fenetre.setVisible(true);
+            threadRendu = std::thread([&rtMoteur] {
+                Trace::nommer_thread("rendu");
+                rtMoteur.creerImage();
+            });
+        }
+
+        if (rtMoteur.mettreAJourTexture()) {
+            sprite.setTexture(rtMoteur.obtenirTexture(), true);
+            fenetre.clear();
+            fenetre.draw(sprite);
+            fenetre.display();
+        }
+
+        if (threadRendu.joinable() && !rtMoteur.estEnTravail()) {
+            threadRendu.join();
+        }
+
+        sf::sleep(sf::milliseconds(10));
+    }
+    if (threadRendu.joinable()) {
+        rtMoteur.interrompre();
+        threadRendu.join();
+    }
+    fenetre.close();
+    terminal.fermer();
+
+    // Apres la fermeture du terminal, pour que les erreurs restent lisibles ; l'image est
+    // enregistree meme si la scene ne peut pas l'etre
+    int code = 0;
+    if (options.a_fichier_dest) {
+        // std::cout << "Saving file to " << fichier_dest << std::endl;
+        code = enregistrerScene(options, rtMoteur);
+    }
+    if (options.sauvegarder_image) {
+        // std::cout << "Saving image to " << fichier_image_dest << std::endl;
+        if (!rtMoteur.sauvegarderImage(options.fichier_image_dest.c_str())) {
+            std::cerr << "Impossible d'enregistrer l'image " << options.fichier_image_dest << std::endl;
+            code = 2;
+        }
+    }
+
+    return terminer(code);
+}
@@ -1,165 +1,328 @@
-#ifndef MATERIAU_H_INCLUDED
-#define MATERIAU_H_INCLUDED
-
-#include "rt.h"
-
-#include "../include/tinyxml2.h"
-
-struct EnregIntersect;
-
-class materiau {
-    public:
-        virtual bool intercation(
-            const rayon& r, const EnregIntersect& rec, couleur& attenuation, rayon& interactionR
-        ) const = 0;
-        virtual tinyxml2::XMLElement* to_xml(tinyxml2::XMLDocument& xmlDoc) const {return nullptr;};
-        static std::shared_ptr<materiau> materiau_from_xml(tinyxml2::XMLElement* pElement);
-};
-
-class LambertianMateriau : public materiau {
-    public:
-        LambertianMateriau(const couleur& a) : diffuseCouleur(a) {}
-
-        LambertianMateriau(tinyxml2::XMLElement* pElement) {
-            tinyxml2::XMLElement * couleur = pElement->FirstChildElement("couleur");
-
-            diffuseCouleur = vecteur3(couleur->DoubleAttribute("r"), couleur->DoubleAttribute("g"), couleur->DoubleAttribute("b"));
-        }
-
-        virtual bool intercation(
-            const rayon& r, const EnregIntersect& rec, couleur& attenuation, rayon& intercationR
-        ) const override {
-            auto intercation_direction = rec.surface_normal + vecteur_unitaire_aleatoire();
-
-            // Catch degenerate intercation direction
-            if (intercation_direction.proche_de_zero())
-                intercation_direction = rec.surface_normal;
-
-            intercationR = rayon(rec.p, intercation_direction, r.temps());
-            attenuation = diffuseCouleur;
-            return true;
-        }
-
-        tinyxml2::XMLElement* to_xml(tinyxml2::XMLDocument& xmlDoc) const {
-            tinyxml2::XMLElement * pElement = xmlDoc.NewElement("LambertianMateriau");
-
-            tinyxml2::XMLElement * couleur = xmlDoc.NewElement("couleur");
-            couleur->SetAttribute("r", diffuseCouleur.x());
-            couleur->SetAttribute("g", diffuseCouleur.y());
-            couleur->SetAttribute("b", diffuseCouleur.z());
-
-            pElement->InsertEndChild(couleur);
-
-            return pElement;
-        }
-
-    public:
-        couleur diffuseCouleur;
-};
-
-class MetalMateriau : public materiau {
-    public:
-        MetalMateriau(const couleur& a, double f) : diffuseCouleur(a), reflectionfuzz(f < 1 ? f : 1) {}
-
-        MetalMateriau(tinyxml2::XMLElement* pElement) {
-            reflectionfuzz = pElement->DoubleAttribute("reflectionfuzz");
-            tinyxml2::XMLElement * couleur = pElement->FirstChildElement("couleur");
-            diffuseCouleur = vecteur3(couleur->DoubleAttribute("r"), couleur->DoubleAttribute("g"), couleur->DoubleAttribute("b"));
-        }
-
-        virtual bool intercation(
-            const rayon& r, const EnregIntersect& rec, couleur& attenuation, rayon& intercationR
-        ) const override {
-            vecteur3 reflected = reflect(vecteur_unitaire(r.direction()), rec.surface_normal);
-            intercationR = rayon(rec.p, reflected + reflectionfuzz*random_in_unit_sphere(), r.temps());
-            attenuation = diffuseCouleur;
-            return (produit_scalaire(intercationR.direction(), rec.surface_normal) > 0);
-        }
-
-        tinyxml2::XMLElement* to_xml(tinyxml2::XMLDocument& xmlDoc) const {
-            tinyxml2::XMLElement * pElement = xmlDoc.NewElement("MetalMateriau");
-
-            tinyxml2::XMLElement * couleur = xmlDoc.NewElement("couleur");
-            couleur->SetAttribute("r", diffuseCouleur.x());
-            couleur->SetAttribute("g", diffuseCouleur.y());
-            couleur->SetAttribute("b", diffuseCouleur.z());
-
-            pElement->InsertEndChild(couleur);
-
-            pElement->SetAttribute("reflectionfuzz", reflectionfuzz);
-
-            return pElement;
-        }
-
-    public:
-        couleur diffuseCouleur;
-        double reflectionfuzz;
-};
-
-class DielectricMateriau : public materiau {
-    public:
-        DielectricMateriau(double indexrefraction) : indexRefraction(indexrefraction) {}
-
-        DielectricMateriau(tinyxml2::XMLElement* pElement) {
-            indexRefraction = pElement->DoubleAttribute("Ir");
-        }
-
-        virtual bool intercation(
-            const rayon& r, const EnregIntersect& rec, couleur& attenuation, rayon& intercationR
-        ) const override {
-            attenuation = couleur(1.0, 1.0, 1.0);
-            double refraction_ratio = rec.front_face ? (1.0/ir) : ir;
-
-            vecteur3 unit_direction = vecteur_unitaire(r.direction());
-            double cos = fmin(produit_scalaire(-unit_direction, rec.surface_normal), 1.0);
-            double sin = sqrt(1.0 - cos*cos);
-
-            bool cannot_refract = refraction_ratio * sin > 1.0;
-            vecteur3 direction;
-
-            if (cannot_refract || reflectance(cos, refraction_ratio) > random_double())
-                direction = reflect(unit_direction, rec.surface_normal);
-            else
-                direction = refract(unit_direction, rec.surface_normal, refraction_ratio);
-
-            intercationR = rayon(rec.p, direction, r.temps());
-            return true;
-        }
-
-        tinyxml2::XMLElement* to_xml(tinyxml2::XMLDocument& xmlDoc) const {
-            tinyxml2::XMLElement * pElement = xmlDoc.NewElement("DielectricMateriau");
-
-            pElement->SetAttribute("indexRefraction ", indexRefraction );
-
-            return pElement;
-        }
-
-    public:
-        double indexRefraction ; // Index of Refraction
-
-	private:
-		static double reflectance(double cosine, double ref_idx) {
-			// Use Schlick's approximation for reflectance.
-			auto r0 = (1-ref_idx) / (1+ref_idx);
-			r0 = r0*r0;
-			return r0 + (1-r0)*pow((1 - cosine),5);
-		}
-};
-
-std::shared_ptr<materiau> materiau::materiau_from_xml(tinyxml2::XMLElement* pElement) {
-    tinyxml2::XMLElement* matElement = pElement->FirstChildElement();
-    if (strcmp(matElement->Name(), "LambertianMateriau") == 0) {
-        return std::make_shared<LambertianMateriau>(matElement);
-    }
-    else if (strcmp(matElement->Name(), "MetalMateriau") == 0) {
-        return std::make_shared<MetalMateriau>(matElement);
-    }
-    else if (strcmp(matElement->Name(), "DielectricMateriau") == 0) {
-        return std::make_shared<DielectricMateriau>(matElement);
-    }
-    else {
-        throw std::invalid_argument("materiau " + std::string(matElement->Name()) + " isn't defined");
-    }
-}
-
-#endif // MATERIAU_H_INCLUDED
+#ifndef MATERIAU_H_INCLUDED
+#define MATERIAU_H_INCLUDED
+
+#include "rt.h"
+#include "Echantillonneur.h"
+
+#include <string>
+#include <vector>
+#include <cstring>
+#include <unordered_map>
+
+#include "../include/tinyxml2.h"
+
+struct EnregIntersect;
+
+// Permet aux integrateurs de regrouper les impacts par materiau sans appel virtuel
+enum class TypeMateriau { Lambertien, Metal, Dielectrique, Emissif };
+
+// Materiau a plat, tel que range dans une scene binaire
+struct MateriauBinaire {
+    uint32_t type;       // TypeMateriau
+    uint32_t reserve;
+    double rgb[3];       // couleur diffuse ou emise
+    double parametre;    // flou du metal ou indice de refraction
+};
+
+class materiau {
+    public:
+        virtual bool intercation(
+            const rayon& r, const EnregIntersect& rec, couleur& attenuation, rayon& interactionR
+        ) const = 0;
+        virtual TypeMateriau type() const = 0;
+
+        // Radiance emise par la surface
+        virtual couleur emis() const { return couleur(0, 0, 0); }
+
+        // Couleur propre de la surface, guide du debruiteur
+        virtual couleur albedo() const { return couleur(1, 1, 1); }
+
+        // BSDF (cosinus inclus) et densite de la direction `direction` quittant l'impact ;
+        // false pour les materiaux speculaires, que l'echantillonnage des lumieres ne peut pas atteindre
+        virtual bool evaluer(const EnregIntersect& rec, const vecteur3& direction, couleur& f, double& pdf) const { return false; }
+
+        virtual tinyxml2::XMLElement* to_xml(tinyxml2::XMLDocument& xmlDoc) const {return nullptr;};
+        static std::shared_ptr<materiau> materiau_from_xml(tinyxml2::XMLElement* pElement);
+
+        virtual MateriauBinaire vers_binaire() const = 0;
+        static std::shared_ptr<materiau> materiau_depuis_binaire(const MateriauBinaire& donnees);
+
+    protected:
+        static MateriauBinaire binaire(TypeMateriau type, const couleur& c, double parametre) {
+            return {static_cast<uint32_t>(type), 0, {c.x(), c.y(), c.z()}, parametre};
+        }
+};
+
+// Materiaux deja lus dans un fichier, indexes par leur texte XML : deux elements
+// <Materiau> identiques donnent le meme objet
+class CacheMateriaux {
+    public:
+        std::shared_ptr<materiau> materiau_from_xml(tinyxml2::XMLElement* pElement);
+
+    private:
+        std::unordered_map<std::string, std::shared_ptr<materiau>> materiaux;
+};
+
+// Table des materiaux de la scene ; les enregistrements d'intersection n'en portent que l'indice
+class TableMateriaux {
+    public:
+        uint32_t enregistrer(const std::shared_ptr<materiau>& m) {
+            auto it = indices.find(m.get());
+            if (it != indices.end()) return it->second;
+            uint32_t indice = static_cast<uint32_t>(materiaux.size());
+            indices.emplace(m.get(), indice);
+            materiaux.push_back(m);
+            return indice;
+        }
+
+        const materiau& operator[](uint32_t indice) const { return *materiaux[indice]; }
+
+        size_t taille() const { return materiaux.size(); }
+
+        void vider() {
+            materiaux.clear();
+            indices.clear();
+        }
+
+    public:
+        std::vector<std::shared_ptr<materiau>> materiaux;
+
+    private:
+        std::unordered_map<const materiau*, uint32_t> indices;
+};
+
+class LambertianMateriau : public materiau {
+    public:
+        LambertianMateriau(const couleur& a) : diffuseCouleur(a) {}
+
+        LambertianMateriau(tinyxml2::XMLElement* pElement) {
+            tinyxml2::XMLElement * couleur = pElement->FirstChildElement("couleur");
+
+            diffuseCouleur = vecteur3(couleur->DoubleAttribute("r"), couleur->DoubleAttribute("g"), couleur->DoubleAttribute("b"));
+        }
+
+        virtual bool intercation(
+            const rayon& r, const EnregIntersect& rec, couleur& attenuation, rayon& intercationR
+        ) const override {
+            auto [u1, u2] = Echantillonneur::echantillon_2d();
+            auto intercation_direction = direction_cosinus(rec.surface_normal, u1, u2);
+
+            intercationR = rayon(rec.p, intercation_direction, r.temps());
+            attenuation = diffuseCouleur;
+            return true;
+        }
+
+        virtual TypeMateriau type() const override { return TypeMateriau::Lambertien; }
+
+        virtual couleur albedo() const override { return diffuseCouleur; }
+
+        virtual MateriauBinaire vers_binaire() const override { return binaire(type(), diffuseCouleur, 0); }
+
+        virtual bool evaluer(const EnregIntersect& rec, const vecteur3& direction, couleur& f, double& pdf) const override {
+            double cos = produit_scalaire(vecteur_unitaire(direction), rec.surface_normal);
+            if (cos <= 0) return false;
+            f = diffuseCouleur * (cos / pi);
+            pdf = cos / pi;
+            return true;
+        }
+
+        tinyxml2::XMLElement* to_xml(tinyxml2::XMLDocument& xmlDoc) const {
+            tinyxml2::XMLElement * pElement = xmlDoc.NewElement("LambertianMateriau");
+
+            tinyxml2::XMLElement * couleur = xmlDoc.NewElement("couleur");
+            couleur->SetAttribute("r", diffuseCouleur.x());
+            couleur->SetAttribute("g", diffuseCouleur.y());
+            couleur->SetAttribute("b", diffuseCouleur.z());
+
+            pElement->InsertEndChild(couleur);
+
+            return pElement;
+        }
+
+    public:
+        couleur diffuseCouleur;
+};
+
+class MetalMateriau : public materiau {
+    public:
+        MetalMateriau(const couleur& a, double f) : diffuseCouleur(a), reflectionfuzz(f < 1 ? f : 1) {}
+
+        MetalMateriau(tinyxml2::XMLElement* pElement) {
+            reflectionfuzz = pElement->DoubleAttribute("reflectionfuzz");
+            tinyxml2::XMLElement * couleur = pElement->FirstChildElement("couleur");
+            diffuseCouleur = vecteur3(couleur->DoubleAttribute("r"), couleur->DoubleAttribute("g"), couleur->DoubleAttribute("b"));
+        }
+
+        virtual bool intercation(
+            const rayon& r, const EnregIntersect& rec, couleur& attenuation, rayon& intercationR
+        ) const override {
+            vecteur3 reflected = reflect(vecteur_unitaire(r.direction()), rec.surface_normal);
+            intercationR = rayon(rec.p, reflected + reflectionfuzz*point_aleatoire_dans_sphere(), r.temps());
+            attenuation = diffuseCouleur;
+            return (produit_scalaire(intercationR.direction(), rec.surface_normal) > 0);
+        }
+
+        virtual TypeMateriau type() const override { return TypeMateriau::Metal; }
+
+        virtual couleur albedo() const override { return diffuseCouleur; }
+
+        virtual MateriauBinaire vers_binaire() const override { return binaire(type(), diffuseCouleur, reflectionfuzz); }
+
+        tinyxml2::XMLElement* to_xml(tinyxml2::XMLDocument& xmlDoc) const {
+            tinyxml2::XMLElement * pElement = xmlDoc.NewElement("MetalMateriau");
+
+            tinyxml2::XMLElement * couleur = xmlDoc.NewElement("couleur");
+            couleur->SetAttribute("r", diffuseCouleur.x());
+            couleur->SetAttribute("g", diffuseCouleur.y());
+            couleur->SetAttribute("b", diffuseCouleur.z());
+
+            pElement->InsertEndChild(couleur);
+
+            pElement->SetAttribute("reflectionfuzz", reflectionfuzz);
+
+            return pElement;
+        }
+
+    public:
+        couleur diffuseCouleur;
+        double reflectionfuzz;
+};
+
+class DielectricMateriau : public materiau {
+    public:
+        DielectricMateriau(double indexrefraction) : indexRefraction(indexrefraction) {}
+
+        // Les anciens fichiers ecrivaient l'indice sous le nom "indexRefraction "
+        DielectricMateriau(tinyxml2::XMLElement* pElement) {
+            indexRefraction = pElement->DoubleAttribute("Ir", pElement->DoubleAttribute("indexRefraction "));
+        }
+
+        virtual bool intercation(
+            const rayon& r, const EnregIntersect& rec, couleur& attenuation, rayon& intercationR
+        ) const override {
+            attenuation = couleur(1.0, 1.0, 1.0);
+            double refraction_ratio = rec.front_face ? (1.0/ir) : ir;
+
+            vecteur3 unit_direction = vecteur_unitaire(r.direction());
+            double cos = fmin(produit_scalaire(-unit_direction, rec.surface_normal), 1.0);
+            double sin = sqrt(1.0 - cos*cos);
+
+            bool cannot_refract = refraction_ratio * sin > 1.0;
+            vecteur3 direction;
+
+            if (cannot_refract || reflectance(cos, refraction_ratio) > Echantillonneur::echantillon_1d())
+                direction = reflect(unit_direction, rec.surface_normal);
+            else
+                direction = refract(unit_direction, rec.surface_normal, refraction_ratio);
+
+            intercationR = rayon(rec.p, direction, r.temps());
+            return true;
+        }
+
+        virtual TypeMateriau type() const override { return TypeMateriau::Dielectrique; }
+
+        virtual MateriauBinaire vers_binaire() const override { return binaire(type(), couleur(1, 1, 1), indexRefraction); }
+
+        tinyxml2::XMLElement* to_xml(tinyxml2::XMLDocument& xmlDoc) const {
+            tinyxml2::XMLElement * pElement = xmlDoc.NewElement("DielectricMateriau");
+
+            pElement->SetAttribute("Ir", indexRefraction);
+
+            return pElement;
+        }
+
+    public:
+        double indexRefraction ; // Index of Refraction
+
+	private:
+		static double reflectance(double cosine, double ref_idx) {
+			// Use Schlick's approximation for reflectance.
+			auto r0 = (1-ref_idx) / (1+ref_idx);
+			r0 = r0*r0;
+			return r0 + (1-r0)*pow((1 - cosine),5);
+		}
+};
+
+// Source de lumiere : absorbe tout rayon incident et emet une radiance constante
+class EmissifMateriau : public materiau {
+    public:
+        EmissifMateriau(const couleur& e) : emission(e) {}
+
+        EmissifMateriau(tinyxml2::XMLElement* pElement) {
+            tinyxml2::XMLElement * couleur = pElement->FirstChildElement("couleur");
+            emission = vecteur3(couleur->DoubleAttribute("r"), couleur->DoubleAttribute("g"), couleur->DoubleAttribute("b"));
+        }
+
+        virtual bool intercation(
+            const rayon& r, const EnregIntersect& rec, couleur& attenuation, rayon& intercationR
+        ) const override {
+            return false;
+        }
+
+        virtual TypeMateriau type() const override { return TypeMateriau::Emissif; }
+
+        virtual couleur emis() const override { return emission; }
+
+        virtual MateriauBinaire vers_binaire() const override { return binaire(type(), emission, 0); }
+
+        tinyxml2::XMLElement* to_xml(tinyxml2::XMLDocument& xmlDoc) const {
+            tinyxml2::XMLElement * pElement = xmlDoc.NewElement("EmissifMateriau");
+
+            tinyxml2::XMLElement * couleur = xmlDoc.NewElement("couleur");
+            couleur->SetAttribute("r", emission.x());
+            couleur->SetAttribute("g", emission.y());
+            couleur->SetAttribute("b", emission.z());
+
+            pElement->InsertEndChild(couleur);
+
+            return pElement;
+        }
+
+    public:
+        couleur emission;
+};
+
+std::shared_ptr<materiau> materiau::materiau_from_xml(tinyxml2::XMLElement* pElement) {
+    tinyxml2::XMLElement* matElement = pElement->FirstChildElement();
+    if (strcmp(matElement->Name(), "LambertianMateriau") == 0) {
+        return std::make_shared<LambertianMateriau>(matElement);
+    }
+    else if (strcmp(matElement->Name(), "MetalMateriau") == 0) {
+        return std::make_shared<MetalMateriau>(matElement);
+    }
+    else if (strcmp(matElement->Name(), "DielectricMateriau") == 0) {
+        return std::make_shared<DielectricMateriau>(matElement);
+    }
+    else if (strcmp(matElement->Name(), "EmissifMateriau") == 0) {
+        return std::make_shared<EmissifMateriau>(matElement);
+    }
+    else {
+        throw std::invalid_argument("materiau " + std::string(matElement->Name()) + " isn't defined");
+    }
+}
+
+std::shared_ptr<materiau> materiau::materiau_depuis_binaire(const MateriauBinaire& donnees) {
+    couleur c(donnees.rgb[0], donnees.rgb[1], donnees.rgb[2]);
+    switch (static_cast<TypeMateriau>(donnees.type)) {
+        case TypeMateriau::Lambertien:   return std::make_shared<LambertianMateriau>(c);
+        case TypeMateriau::Metal:        return std::make_shared<MetalMateriau>(c, donnees.parametre);
+        case TypeMateriau::Dielectrique: return std::make_shared<DielectricMateriau>(donnees.parametre);
+        case TypeMateriau::Emissif:      return std::make_shared<EmissifMateriau>(c);
+    }
+    throw std::invalid_argument("materiau binaire " + std::to_string(donnees.type) + " isn't defined");
+}
+
+std::shared_ptr<materiau> CacheMateriaux::materiau_from_xml(tinyxml2::XMLElement* pElement) {
+    tinyxml2::XMLPrinter printer(nullptr, true);
+    pElement->FirstChildElement()->Accept(&printer);
+    std::string cle(printer.CStr());
+
+    auto it = materiaux.find(cle);
+    if (it != materiaux.end()) return it->second;
+
+    auto m = materiau::materiau_from_xml(pElement);
+    materiaux.emplace(cle, m);
+    return m;
+}
+
+#endif // MATERIAU_H_INCLUDED
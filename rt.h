@@ -1,46 +1,107 @@
-#ifndef RT_H_INCLUDED
-#define RT_H_INCLUDED
-#include "vecteur3.h"
-#include <cmath>
-#include <limits>
-#include <memory>
-#include <cstdlib>
-#include <random>
-
-const double infinity = std::numeric_limits<double>::infinity();
-const double pi = 3.1415926535897932385;
-
-using std::shared_ptr;
-using std::make_shared;
-using std::sqrt;
-
-inline double deg_rad(double deg) {
-    return deg * pi / 180.0;
-}
-
-class Random {
-public:
-
-    static double random_double() {
-        return distribution(generator);
-    }
-
-
-    static double random_double(double min, double max) {
-        return min + (max - min) * random_double();
-    }
-
-private:
-    static std::uniform_real_distribution<double> distribution;
-    static std::mt19937 generator;
-};
-
-inline double constrain(double x, double min, double max) {
-    if (x < min) return min;
-    if (x > max) return max;
-    return x;
-}
-
-
-
-#endif // RT_H_INCLUDED
+#ifndef RT_H_INCLUDED
+#define RT_H_INCLUDED
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <cstdlib>
+#include <random>
+
+const double infinity = std::numeric_limits<double>::infinity();
+const double pi = 3.1415926535897932385;
+
+using std::shared_ptr;
+using std::make_shared;
+using std::sqrt;
+
+inline double deg_rad(double deg) {
+    return deg * pi / 180.0;
+}
+
+// Generateur PCG32 (O'Neill) : 16 octets d'etat et 2^63 flux independants choisis par `increment`
+class PCG32 {
+public:
+    PCG32() : etat(0x853c49e6748fea9bULL), increment(0xda3e39cb94b95bdbULL) {}
+    PCG32(uint64_t graine, uint64_t flux) { initialiser(graine, flux); }
+
+    void initialiser(uint64_t graine, uint64_t flux) {
+        etat = 0;
+        increment = (flux << 1u) | 1u;
+        suivant();
+        etat += graine;
+        suivant();
+    }
+
+    uint32_t suivant() {
+        uint64_t ancien = etat;
+        etat = ancien * 6364136223846793005ULL + increment;
+        uint32_t melange = static_cast<uint32_t>(((ancien >> 18u) ^ ancien) >> 27u);
+        uint32_t rotation = static_cast<uint32_t>(ancien >> 59u);
+        return (melange >> rotation) | (melange << ((-rotation) & 31));
+    }
+
+    // Uniforme dans [0, 1)
+    double uniforme() {
+        return suivant() * (1.0 / 4294967296.0);
+    }
+
+public:
+    uint64_t etat;
+    uint64_t increment;
+};
+
+// Finaliseur de SplitMix64, pour decorreler des cles voisines (numero d'echantillon, graine)
+inline uint64_t melanger_bits(uint64_t x) {
+    x += 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+// Chaque thread possede son propre generateur. Le moteur le repositionne sur un flux
+// determine par (pixel, echantillon) avant chaque echantillon : l'image ne depend donc
+// ni du nombre de threads ni de l'ordre dans lequel les pixels sont traites.
+class Random {
+public:
+
+    static double random_double() {
+        return generateur.uniforme();
+    }
+
+
+    static double random_double(double min, double max) {
+        return min + (max - min) * random_double();
+    }
+
+    static void initialiser_flux(uint64_t pixel, uint64_t echantillon) {
+        generateur.initialiser(melanger_bits(graine ^ melanger_bits(echantillon)), pixel);
+    }
+
+    static void definir_graine(uint64_t valeur) { graine = valeur; }
+    static uint64_t obtenir_graine() { return graine; }
+
+    // Acces a l'etat du thread courant, pour suspendre et reprendre un flux
+    static PCG32& flux() { return generateur; }
+
+private:
+    static inline thread_local PCG32 generateur;
+    static inline uint64_t graine = 0;
+};
+
+inline double random_double() {
+    return Random::random_double();
+}
+
+inline double random_double(double min, double max) {
+    return Random::random_double(min, max);
+}
+
+inline double constrain(double x, double min, double max) {
+    if (x < min) return min;
+    if (x > max) return max;
+    return x;
+}
+
+
+
+#endif // RT_H_INCLUDED
@@ -1,98 +1,107 @@
-#ifndef SPHERE_H_INCLUDED
-#define SPHERE_H_INCLUDED
-
-#include "ObjectHit.h"
-#include "vecteur3.h"
-
-#include "../include/tinyxml2.h"
-
-#include "materiau.h"
-class SphereObject :public Object {
-public:
-    point center;
-    double radius;
-    std::shared_ptr<Materiau> Materiau;
-    SphereObject() {}
-    SphereObject(point center, double radius) : center(center), radius(radius) {};
-    SphereObject(point center, double radius, std::shared_ptr<Materiau> Materiau)
-        : center(center), radius(radius), materiau(Materiau) {};
-    SphereObject(tinyxml2::XMLElement* element);
-
-    virtual bool intersect(
-        const rayon& r, double t_min, double t_max, EnregIntersect& record) const override;
-
-    virtual bool bounding_Box(double time0, double time1, boundingBox& ob) const override;
-
-    virtual tinyxml2::XMLElement* toXml(tinyxml2::XMLDocument& xmlDoc) const override;
-
-
-};
-
-SphereObject::SphereObject(tinyxml2::XMLElement* element) {
-    radius = element->DoubleAttribute("Radius");
-
-    tinyxml2::XMLElement* centerXml = element->FirstChildElement("Center");
-    center = point(centerXml->DoubleAttribute("x"), centerXml->DoubleAttribute("y"), centerXml->DoubleAttribute("z"));
-
-    materiau = Materiau::createFromXml(element->FirstChildElement("Materiau"));
-}
-
-bool SphereObject::intersect(const rayon& r, double t_min, double t_max, EnregIntersect& record) const {
-    Vecteur3 oc = r.origin() - center;
-    auto a = r.direction().norme2();
-    auto half = produit_scalaire(oc, r.direction());
-    auto c = oc.norme2() - radius * radius;
-
-    auto discr = half * half - a * c;
-    if (discr < 0) return false;
-    auto sqrtD = sqrt(discr);
-
-    auto root = (-half - sqrtD) / a;
-    if (root < t_min || t_max < root) {
-        root = (-half + sqrtD) / a;
-        if (root < t_min || t_max < root)
-            return false;
-    }
-
-    record.t = root;
-    record.point = r.at(record.t);
-    vecteur3 surface_normal_at_intersection = (record.point - center) / radius;
-    record.compute_face_normal(r, surface_normal_at_intersection);
-    record.materiau_ptr = materiau;
-
-    return true;
-}
-
-bool SphereObject::bounding_Box(double time0, double time1, BoundingBox& ob) const {
-    ob= BoundingBox(
-        center - vecteur3(radius, radius, radius),
-        center + vecteur3(radius, radius, radius));
-    return true;
-}
-
-tinyxml2::XMLElement* SphereObject::toXml(tinyxml2::XMLDocument& xmlDoc) const {
-    tinyxml2::XMLElement* element = xmlDoc.NewElement("Sphere");
-
-    element->SetAttribute("Radius", radius);
-
-    tinyxml2::XMLElement* centerXml = xmlDoc.NewElement("Center");
-
-    centerXml->SetAttribute("x", center.x());
-    centerXml->SetAttribute("y", center.y());
-    centerXml->SetAttribute("z", center.z());
-
-    element->InsertEndChild(centerXml);
-
-    tinyxml2::XMLElement* MateriauXml = xmlDoc.NewElement("Materiau");
-    tinyxml2::XMLElement* MateriauElement = materiau->toXml(xmlDoc);
-
-    MateriauXml->InsertEndChild(MateriauElement);
-
-    element->InsertEndChild(MateriauXml);
-
-    return element;
-}
-
-
-
-#endif // SPHERE_H_INCLUDED
+#ifndef SPHERE_H_INCLUDED
+#define SPHERE_H_INCLUDED
+
+#include "ObjectHit.h"
+#include "vecteur3.h"
+
+#include "../include/tinyxml2.h"
+
+#include "materiau.h"
+class SphereObject :public Object {
+public:
+    point center;
+    double radius;
+    std::shared_ptr<materiau> materiau_ptr;
+    uint32_t materiau_id = 0;
+    uint32_t primitive_id = 0;
+    SphereObject() {}
+    SphereObject(point center, double radius) : center(center), radius(radius) {};
+    SphereObject(point center, double radius, std::shared_ptr<materiau> m)
+        : center(center), radius(radius), materiau_ptr(m) {};
+    SphereObject(tinyxml2::XMLElement* element, CacheMateriaux* cache = nullptr);
+
+    virtual bool intersect(
+        const rayon& r, double t_min, double t_max, EnregIntersect& record) const override;
+
+    virtual bool bounding_box(double time0, double time1, BoundingBox& ob) const override;
+
+    virtual tinyxml2::XMLElement* to_xml(tinyxml2::XMLDocument& xmlDoc) const override;
+
+    virtual void indexer(TableMateriaux& table, uint32_t& prochaine_primitive) override {
+        materiau_id = table.enregistrer(materiau_ptr);
+        primitive_id = prochaine_primitive++;
+    }
+
+
+};
+
+SphereObject::SphereObject(tinyxml2::XMLElement* element, CacheMateriaux* cache) {
+    radius = element->DoubleAttribute("Radius");
+
+    tinyxml2::XMLElement* centerXml = element->FirstChildElement("Center");
+    center = point(centerXml->DoubleAttribute("x"), centerXml->DoubleAttribute("y"), centerXml->DoubleAttribute("z"));
+
+    tinyxml2::XMLElement* materiauXml = element->FirstChildElement("Materiau");
+    materiau_ptr = cache ? cache->materiau_from_xml(materiauXml) : materiau::materiau_from_xml(materiauXml);
+}
+
+bool SphereObject::intersect(const rayon& r, double t_min, double t_max, EnregIntersect& record) const {
+    vecteur3 oc = r.origine() - center;
+    auto a = r.direction().norme2();
+    auto half = produit_scalaire(oc, r.direction());
+    auto c = oc.norme2() - radius * radius;
+
+    auto discr = half * half - a * c;
+    if (discr < 0) return false;
+    auto sqrtD = sqrt(discr);
+
+    auto root = (-half - sqrtD) / a;
+    if (root < t_min || t_max < root) {
+        root = (-half + sqrtD) / a;
+        if (root < t_min || t_max < root)
+            return false;
+    }
+
+    record.t = root;
+    record.p = r.pt_a_distance(record.t);
+    vecteur3 surface_normal_at_intersection = (record.p - center) / radius;
+    record.compute_face_normal(r, surface_normal_at_intersection);
+    record.materiau_id = materiau_id;
+    record.primitive_id = primitive_id;
+
+    return true;
+}
+
+bool SphereObject::bounding_box(double time0, double time1, BoundingBox& ob) const {
+    ob= BoundingBox(
+        center - vecteur3(radius, radius, radius),
+        center + vecteur3(radius, radius, radius));
+    return true;
+}
+
+tinyxml2::XMLElement* SphereObject::to_xml(tinyxml2::XMLDocument& xmlDoc) const {
+    tinyxml2::XMLElement* element = xmlDoc.NewElement("Sphere");
+
+    element->SetAttribute("Radius", radius);
+
+    tinyxml2::XMLElement* centerXml = xmlDoc.NewElement("Center");
+
+    centerXml->SetAttribute("x", center.x());
+    centerXml->SetAttribute("y", center.y());
+    centerXml->SetAttribute("z", center.z());
+
+    element->InsertEndChild(centerXml);
+
+    tinyxml2::XMLElement* MateriauXml = xmlDoc.NewElement("Materiau");
+    tinyxml2::XMLElement* MateriauElement = materiau_ptr->to_xml(xmlDoc);
+
+    MateriauXml->InsertEndChild(MateriauElement);
+
+    element->InsertEndChild(MateriauXml);
+
+    return element;
+}
+
+
+
+#endif // SPHERE_H_INCLUDED